@@ -0,0 +1,237 @@
+/**
+	lxSPSCRing / lxMPMCRing throughput and hand-off latency.
+
+	Slots are lxVec3DBatch<64> (AoS) or lxVec3DBatchSoA<64> and are used in place (zero copy) :
+	the producer fills every point of the slot, the consumer reads every point back.
+	Two modes, run one after the other :
+	- throughput	: producers push as fast as they can, the ring is mostly full or mostly empty
+					  depending on the slower side. Report items/s (batches handed over per second)
+					  and points/s = items/s * 64. No latency here : a batch waiting in a full ring
+					  would measure the queue length, not the hand-off.
+	- latency		: paced, one batch in flight : a producer only acquires a slot once the previous
+					  batch was released by its consumer. Report p50 / p99 of the time from CommitWrite()
+					  on the producer to TryAcquireRead() success on the consumer (includes the consumer
+					  polling delay and the cache line transfer of the slot index, not the batch fill / read).
+
+	SPSC runs 1 x 1. MPMC sweeps producers x consumers over {1, 2, 4, ...} up to maxThreads per side.
+	When producers + consumers exceed the hardware thread count, sides yield instead of spinning
+	and the numbers mostly measure the scheduler.
+
+	Build & run (from the repository root) :
+		g++ -std=c++11 -O2 -pthread -I. bench/lxRingBench.cpp -o lxRingBench
+		./lxRingBench [batchCount = 200000] [maxThreads = 4]
+	Latency mode runs batchCount / 10 batches.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include "../lxRing.h"
+#include "../lxParallel.h"
+
+using namespace lx;
+
+#define BATCH_SIZE		(64)
+#define RING_CAPACITY	(64)
+
+// =================================================================
+//   Slot : batch + commit time stamp for the latency measure.
+// =================================================================
+
+template <class BATCH>
+class StampedBatch {
+public:
+	BATCH	batch;
+	u64		stamp;
+};
+
+optinline
+u64 NowNs() {
+	return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// --- Fill / read one batch in place, per layout ---
+
+optinline void FillBatch(lxVec3DBatch<BATCH_SIZE>& b, u32 seed) {
+	for (u32 n = 0; n < BATCH_SIZE; n++) {
+		float f = (float)(seed + n);
+		b.points[n].x = f; b.points[n].y = f + 1.0f; b.points[n].z = f + 2.0f;
+	}
+	b.count = BATCH_SIZE;
+}
+
+optinline float ReadBatch(const lxVec3DBatch<BATCH_SIZE>& b) {
+	float sum = 0.0f;
+	for (u32 n = 0; n < b.count; n++) { sum += b.points[n].x + b.points[n].y + b.points[n].z; }
+	return sum;
+}
+
+optinline void FillBatch(lxVec3DBatchSoA<BATCH_SIZE>& b, u32 seed) {
+	for (u32 n = 0; n < BATCH_SIZE; n++) {
+		float f = (float)(seed + n);
+		b.x[n] = f; b.y[n] = f + 1.0f; b.z[n] = f + 2.0f;
+	}
+	b.count = BATCH_SIZE;
+}
+
+optinline float ReadBatch(const lxVec3DBatchSoA<BATCH_SIZE>& b) {
+	float sum = 0.0f;
+	for (u32 n = 0; n < b.count; n++) { sum += b.x[n] + b.y[n] + b.z[n]; }
+	return sum;
+}
+
+// =================================================================
+//   Ring adapters : same producer / consumer code for both rings.
+// =================================================================
+
+template <class T>
+class SPSCSide {
+public:
+	typedef lxSPSCRing<T> Ring;
+	static const char* Name() { return "SPSC"; }
+	u32 ticket;	// Unused, keeps the interface identical.
+	T*   AcquireWrite(Ring& r)	{ return r.TryAcquireWrite();	}
+	void CommitWrite(Ring& r)	{ r.CommitWrite();				}
+	T*   AcquireRead(Ring& r)	{ return r.TryAcquireRead();	}
+	void ReleaseRead(Ring& r)	{ r.ReleaseRead();				}
+};
+
+template <class T>
+class MPMCSide {
+public:
+	typedef lxMPMCRing<T> Ring;
+	static const char* Name() { return "MPMC"; }
+	u32 ticket;
+	T*   AcquireWrite(Ring& r)	{ return r.TryAcquireWrite(ticket);	}
+	void CommitWrite(Ring& r)	{ r.CommitWrite(ticket);				}
+	T*   AcquireRead(Ring& r)	{ return r.TryAcquireRead(ticket);	}
+	void ReleaseRead(Ring& r)	{ r.ReleaseRead(ticket);				}
+};
+
+// =================================================================
+//   One run : producers x consumers, batchCount batches in total.
+// =================================================================
+
+template <class SIDE, class BATCH>
+void Run(const char* layout, u32 producers, u32 consumers, u32 batchCount, bool paced, bool oversubscribed) {
+	typedef StampedBatch<BATCH>		Slot;
+	typedef typename SIDE::Ring		Ring;
+
+	Ring						ring(RING_CAPACITY);
+	std::atomic<u32>			consumed(0);
+	std::atomic<u32>			inFlight(0);	// Paced mode : 1 while a batch is between CommitWrite and ReleaseRead.
+	std::vector<std::vector<u32> >	latencies(consumers);	// ns, per consumer : no sharing while running.
+	std::vector<float>			sums(consumers, 0.0f);
+
+	std::vector<std::thread>	threads;
+	u64 start = NowNs();
+
+	for (u32 p = 0; p < producers; p++) {
+		// Split batchCount over the producers, the first ones take the remainder.
+		u32 count = (batchCount / producers) + ((p < (batchCount % producers)) ? 1 : 0);
+		threads.push_back(std::thread([&ring, &inFlight, p, count, paced, oversubscribed]() {
+			SIDE side;
+			for (u32 n = 0; n < count; n++) {
+				if (paced) {
+					// Take the single in flight token : wait until the previous batch was released.
+					u32 expected = 0;
+					while (!inFlight.compare_exchange_weak(expected, 1, std::memory_order_acquire)) {
+						expected = 0;
+						if (oversubscribed) { std::this_thread::yield(); }
+					}
+				}
+				Slot* slot;
+				while ((slot = side.AcquireWrite(ring)) == NULL) {
+					if (oversubscribed) { std::this_thread::yield(); }
+				}
+				FillBatch(slot->batch, (p << 20) + n);
+				if (paced) { slot->stamp = NowNs(); }
+				side.CommitWrite(ring);
+			}
+		}));
+	}
+
+	for (u32 c = 0; c < consumers; c++) {
+		if (paced) { latencies[c].reserve(batchCount); }
+		threads.push_back(std::thread([&ring, &consumed, &inFlight, &latencies, &sums, c, batchCount, paced, oversubscribed]() {
+			SIDE side;
+			std::vector<u32>& lat = latencies[c];
+			float sum = 0.0f;
+			while (consumed.load(std::memory_order_relaxed) < batchCount) {
+				Slot* slot = side.AcquireRead(ring);
+				if (slot == NULL) {
+					if (oversubscribed) { std::this_thread::yield(); }
+					continue;
+				}
+				if (paced) {
+					u64 now = NowNs();
+					lat.push_back((u32)std::min<u64>(now - slot->stamp, 0xFFFFFFFFULL));
+				}
+				sum += ReadBatch(slot->batch);
+				side.ReleaseRead(ring);
+				consumed.fetch_add(1, std::memory_order_relaxed);
+				if (paced) { inFlight.store(0, std::memory_order_release); }
+			}
+			sums[c] = sum;
+		}));
+	}
+
+	for (u32 t = 0; t < threads.size(); t++) { threads[t].join(); }
+	double seconds = (double)(NowNs() - start) * 1e-9;
+
+	float checksum = 0.0f;
+	for (u32 c = 0; c < consumers; c++) { checksum += sums[c]; }
+	const char* note = oversubscribed ? "  [oversubscribed]" : "";
+
+	if (!paced) {
+		double itemsPerSec = (double)batchCount / seconds;
+		printf("%s %-4s %2u x %-2u  %12.0f items/s  %14.0f points/s%s  (%g)\n",
+			SIDE::Name(), layout, producers, consumers, itemsPerSec, itemsPerSec * BATCH_SIZE,
+			note, (double)checksum);	// Printed so the consumer reads are not optimized away.
+		return;
+	}
+
+	std::vector<u32> all;
+	all.reserve(batchCount);
+	for (u32 c = 0; c < consumers; c++) { all.insert(all.end(), latencies[c].begin(), latencies[c].end()); }
+	size_t p50 = all.size() / 2;
+	size_t p99 = (all.size() * 99) / 100;
+	std::nth_element(all.begin(), all.begin() + p50, all.end());	u32 lat50 = all[p50];
+	std::nth_element(all.begin(), all.begin() + p99, all.end());	u32 lat99 = all[p99];
+	printf("%s %-4s %2u x %-2u  p50 %8u ns  p99 %9u ns%s  (%g)\n",
+		SIDE::Name(), layout, producers, consumers, lat50, lat99, note, (double)checksum);
+}
+
+template <class BATCH>
+void Sweep(const char* layout, u32 batchCount, u32 maxThreads, u32 hwThreads, bool paced) {
+	Run<SPSCSide<StampedBatch<BATCH> >, BATCH>(layout, 1, 1, batchCount, paced, hwThreads < 2);
+	for (u32 p = 1; p <= maxThreads; p *= 2) {
+		for (u32 c = 1; c <= maxThreads; c *= 2) {
+			Run<MPMCSide<StampedBatch<BATCH> >, BATCH>(layout, p, c, batchCount, paced, (p + c) > hwThreads);
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	u32 batchCount = (argc > 1) ? (u32)atoi(argv[1]) : 200000;
+	u32 maxThreads = (argc > 2) ? (u32)atoi(argv[2]) : 4;
+	if (batchCount == 0) { batchCount = 1; }
+	if (maxThreads == 0) { maxThreads = 1; }
+	u32 hwThreads  = lxParallel::DefaultThreadCount();
+
+	// One hand-off at a time is much slower : fewer batches give enough samples for p99.
+	u32 latencyCount = (batchCount / 10) + 1;
+
+	printf("lxRingBench : batches of %u points, ring capacity %u, %u hardware threads\n",
+		BATCH_SIZE, RING_CAPACITY, hwThreads);
+	printf("--- Throughput, saturated, %u batches ---\n", batchCount);
+	Sweep<lxVec3DBatch   <BATCH_SIZE> >("AoS", batchCount, maxThreads, hwThreads, false);
+	Sweep<lxVec3DBatchSoA<BATCH_SIZE> >("SoA", batchCount, maxThreads, hwThreads, false);
+	printf("--- Hand-off latency, one batch in flight, %u batches ---\n", latencyCount);
+	Sweep<lxVec3DBatch   <BATCH_SIZE> >("AoS", latencyCount, maxThreads, hwThreads, true);
+	Sweep<lxVec3DBatchSoA<BATCH_SIZE> >("SoA", latencyCount, maxThreads, hwThreads, true);
+	return 0;
+}
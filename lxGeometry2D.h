@@ -0,0 +1,412 @@
+/**
+	2D geometry predicates and batched point in polygon on Vec2D.
+
+	Predicates come in two flavors :
+	- Fast  : float evaluation, sign may be wrong for nearly collinear points.
+	- Exact : sign is always right for finite float inputs (no overflow).
+	          Double precision evaluation with Shewchuk error bound filter,
+	          falls back to exact expansion arithmetic only when the filter fails (rare).
+
+	lxPolygonTester2D : many points against one polygon (even-odd rule).
+	Edges are sorted into horizontal slabs (buckets) so a point only
+	tests the edges crossing its slab. Edge data is stored as SoA.
+	- Test()		: one point, scalar loop on the edges of its slab (a slab holds few edges).
+	- TestBatch*()	: points are sorted by slab, then LANES points of the same slab are tested
+					  together against each edge of that slab : the lane loop has a constant trip count
+					  and is branchless, GCC vectorizes it at -O2 (SSE2 / AVX / NEON).
+					  Polygons with less than 4 edges per slab on average use Test() per point.
+*/
+#ifndef LX_GEOMETRY2D_H
+#define LX_GEOMETRY2D_H
+
+#include <math.h>
+#include <vector>
+#include "lxVectors.h"	// And includes lxHack.h, lxTypes.h
+#include "lxParallel.h"
+
+namespace lx {
+
+	class lxGeometry2D {
+	public:
+		// =================================================================
+		//   Orientation
+		// =================================================================
+
+		/** -1, 0, +1 : float evaluation */
+		optinline static
+		s32 OrientationSign(const Vec2D& a, const Vec2D& b, const Vec2D& c) {
+			float det = Vec2D::Orientation(a, b, c);
+			return (det > 0.0f) - (det < 0.0f);
+		}
+
+		/** -1, 0, +1 : exact sign of (b-a) perpdot (c-a) */
+		static
+		s32 OrientationSignExact(const Vec2D& a, const Vec2D& b, const Vec2D& c) {
+			// Float differences are most of the time exact in double, products always are.
+			double detLeft  = ((double)b.x - a.x) * ((double)c.y - a.y);
+			double detRight = ((double)b.y - a.y) * ((double)c.x - a.x);
+			double det      = detLeft - detRight;
+
+			// Shewchuk orient2d filter : ccwerrboundA = (3 + 16 eps) * eps, eps = 2^-53
+			const double ERRBOUND = 3.3306690738754706e-16;
+			double bound = ERRBOUND * (fabs(detLeft) + fabs(detRight));
+			if (det >  bound) { return  1; }
+			if (det < -bound) { return -1; }
+
+			// Exact : expand det into 6 products of two floats (exact in double)
+			// and sum them as a non overlapping expansion.
+			double terms[6] = {
+				 (double)b.x * c.y, -(double)b.x * a.y, -(double)a.x * c.y,
+				-(double)b.y * c.x,  (double)b.y * a.x,  (double)a.y * c.x
+			};
+			double e[6];
+			int count = 0;
+			for (int t = 0; t < 6; t++) {
+				double q = terms[t];
+				int write = 0;
+				for (int i = 0; i < count; i++) {
+					// TwoSum (Knuth) : q + e[i] = sum + err exactly.
+					double sum = q + e[i];
+					double bv  = sum - q;
+					double av  = sum - bv;
+					double err = (q - av) + (e[i] - bv);
+					q = sum;
+					if (err != 0.0) { e[write++] = err; }
+				}
+				if (q != 0.0) { e[write++] = q; }
+				count = write;
+			}
+			// Components are non overlapping, increasing magnitude : the last one gives the sign.
+			if (count == 0) { return 0; }
+			return (e[count - 1] > 0.0) ? 1 : -1;
+		}
+
+		// =================================================================
+		//   Segments
+		// =================================================================
+
+		/** c collinear with [a,b] : is c inside the bounding box of [a,b] */
+		optinline static
+		bool OnSegmentCollinear(const Vec2D& a, const Vec2D& b, const Vec2D& c) {
+			return	(c.x >= (a.x < b.x ? a.x : b.x)) && (c.x <= (a.x > b.x ? a.x : b.x)) &&
+					(c.y >= (a.y < b.y ? a.y : b.y)) && (c.y <= (a.y > b.y ? a.y : b.y));
+		}
+
+		/** True if [p1,p2] and [q1,q2] share at least one point (touching end points and collinear overlap included) */
+		static
+		bool SegmentsIntersect(const Vec2D& p1, const Vec2D& p2, const Vec2D& q1, const Vec2D& q2, bool exact = false) {
+			s32 o1, o2, o3, o4;
+			if (exact) {
+				o1 = OrientationSignExact(p1, p2, q1);
+				o2 = OrientationSignExact(p1, p2, q2);
+				o3 = OrientationSignExact(q1, q2, p1);
+				o4 = OrientationSignExact(q1, q2, p2);
+			} else {
+				o1 = OrientationSign(p1, p2, q1);
+				o2 = OrientationSign(p1, p2, q2);
+				o3 = OrientationSign(q1, q2, p1);
+				o4 = OrientationSign(q1, q2, p2);
+			}
+
+			if ((o1 * o2 < 0) && (o3 * o4 < 0))				{ return true; }
+			if ((o1 == 0) && OnSegmentCollinear(p1, p2, q1))	{ return true; }
+			if ((o2 == 0) && OnSegmentCollinear(p1, p2, q2))	{ return true; }
+			if ((o3 == 0) && OnSegmentCollinear(q1, q2, p1))	{ return true; }
+			if ((o4 == 0) && OnSegmentCollinear(q1, q2, p2))	{ return true; }
+			return false;
+		}
+
+		/** Intersection point of two non parallel segments.
+			Return false if the segments are parallel (or degenerated) or do not intersect.
+			factorP : position on [p1,p2], same convention as Vec2D::GetPoint */
+		static
+		bool SegmentIntersection(const Vec2D& p1, const Vec2D& p2, const Vec2D& q1, const Vec2D& q2, Vec2D& outPoint, float& factorP) {
+			Vec2D r = p2 - p1;
+			Vec2D s = q2 - q1;
+			float denom = r.PerpDot(s);
+			if (denom == 0.0f) { return false; }
+
+			Vec2D qp = q1 - p1;
+			float t = qp.PerpDot(s) / denom;
+			float u = qp.PerpDot(r) / denom;
+			if ((t < 0.0f) || (t > 1.0f) || (u < 0.0f) || (u > 1.0f)) { return false; }
+
+			Vec2D point = Vec2D::GetPoint(p1, p2, t);
+			factorP    = t;
+			outPoint.x = point.x;
+			outPoint.y = point.y;
+			return true;
+		}
+
+		// =================================================================
+		//   Point in polygon
+		// =================================================================
+
+		/** Even-odd rule, polygon is implicitly closed (last vertex connects to first).
+			Crossing number on a ray toward +x, edges are half open in y so shared vertices count once. */
+		static
+		bool PointInPolygon(const Vec2D& p, const Vec2D* polygon, u32 vertexCount) {
+			u32 inside = 0;
+			for (u32 i = 0, j = vertexCount - 1; i < vertexCount; j = i++) {
+				const Vec2D& a = polygon[j];
+				const Vec2D& b = polygon[i];
+				if ((a.y > p.y) != (b.y > p.y)) {
+					float xCross = a.x + ((p.y - a.y) * (b.x - a.x)) / (b.y - a.y);
+					inside ^= (p.x < xCross);
+				}
+			}
+			return inside != 0;
+		}
+	};
+
+	// =================================================================
+	//   Many points against one polygon.
+	//   Build is O(edges * slabs crossed), memory is one SoA entry per (edge, slab).
+	//   Worst case (comb / star polygons, most edges spanning the full height) would be
+	//   edges * bucketCount entries : bucketCount is lowered until the total is at most
+	//   MAX_ENTRIES_PER_EDGE * edges entries (16 bytes each).
+	// =================================================================
+	class lxPolygonTester2D {
+	public:
+		/** bucketCount = 0 : pick one from the edge count. Lowered if needed by the memory cap (see above). */
+		lxPolygonTester2D(const Vec2D* polygon, u32 vertexCount, u32 bucketCount = 0) {
+			Build(polygon, vertexCount, bucketCount);
+		}
+
+		/** Less than 3 vertices : empty tester, every point is outside */
+		void Build(const Vec2D* polygon, u32 vertexCount, u32 bucketCount = 0) {
+			if (vertexCount < 3) {
+				m_minY			= 0.0f;
+				m_maxY			= 0.0f;	// Test() rejects every y before reading a bucket.
+				m_bucketScale	= 0.0f;
+				m_bucketCount	= 1;
+				m_bucketStart.assign(2, 0);
+				m_yMin  .clear();
+				m_yMax  .clear();
+				m_xAtMin.clear();
+				m_slope .clear();
+				return;
+			}
+
+			m_minY = polygon[0].y;
+			m_maxY = polygon[0].y;
+			for (u32 i = 1; i < vertexCount; i++) {
+				if (polygon[i].y < m_minY) { m_minY = polygon[i].y; }
+				if (polygon[i].y > m_maxY) { m_maxY = polygon[i].y; }
+			}
+
+			if (bucketCount == 0) {
+				bucketCount = (vertexCount / 4) + 1;
+				if (bucketCount > 4096) { bucketCount = 4096; }
+			}
+			SetBucketCount(bucketCount);
+
+			// Memory cap. entries ~= edges + bucketCount * (sum of edge heights / height) :
+			// solve for the bucket count giving the cap, repeat while slab rounding still exceeds it.
+			u64 edges   = 0;
+			u64 entries = CountEntries(polygon, vertexCount, edges);
+			u64 cap     = MAX_ENTRIES_PER_EDGE * edges;
+			while ((entries > cap) && (bucketCount > 1)) {
+				u64 lower = ((u64)bucketCount * (cap - edges)) / (entries - edges + 1);
+				bucketCount = (lower < bucketCount) ? (u32)lower : (bucketCount - 1);
+				if (bucketCount == 0) { bucketCount = 1; }
+				SetBucketCount(bucketCount);
+				entries = CountEntries(polygon, vertexCount, edges);
+			}
+
+			// Counting sort of (edge, bucket) pairs into CSR.
+			m_bucketStart.assign(bucketCount + 1, 0);
+			for (int pass = 0; pass < 2; pass++) {
+				if (pass == 1) {
+					u32 total = 0;
+					for (u32 b = 0; b < bucketCount; b++) {
+						u32 c = m_bucketStart[b];
+						m_bucketStart[b] = total;
+						total += c;
+					}
+					m_bucketStart[bucketCount] = total;
+					m_yMin  .resize(total);
+					m_yMax  .resize(total);
+					m_xAtMin.resize(total);
+					m_slope .resize(total);
+				}
+				std::vector<u32> cursor(m_bucketStart.begin(), m_bucketStart.end());
+
+				for (u32 i = 0, j = vertexCount - 1; i < vertexCount; j = i++) {
+					const Vec2D& a = polygon[j];
+					const Vec2D& b = polygon[i];
+					if (a.y == b.y) { continue; }	// Horizontal edge never cross a horizontal ray.
+					const Vec2D& lo = (a.y < b.y) ? a : b;
+					const Vec2D& hi = (a.y < b.y) ? b : a;
+					u32 first = BucketIndex(lo.y);
+					u32 last  = BucketIndex(hi.y);
+					for (u32 bk = first; bk <= last; bk++) {
+						if (pass == 0) {
+							m_bucketStart[bk]++;
+						} else {
+							u32 w = cursor[bk]++;
+							m_yMin  [w] = lo.y;
+							m_yMax  [w] = hi.y;
+							m_xAtMin[w] = lo.x;
+							m_slope [w] = (hi.x - lo.x) / (hi.y - lo.y);
+						}
+					}
+				}
+			}
+		}
+
+		bool Test(const Vec2D& p) const {
+			if ((p.y < m_minY) || (p.y >= m_maxY)) { return false; }
+			u32 bk = BucketIndex(p.y);
+			const float* yMin	= &m_yMin[0];
+			const float* yMax	= &m_yMax[0];
+			const float* xAtMin	= &m_xAtMin[0];
+			const float* slope	= &m_slope[0];
+			u32 inside = 0;
+			// Few edges per slab : kept scalar, batches use the lane version in TestRange().
+			for (u32 e = m_bucketStart[bk]; e < m_bucketStart[bk + 1]; e++) {
+				u32 inSpan = (yMin[e] <= p.y) & (p.y < yMax[e]);
+				u32 left   = p.x < (xAtMin[e] + ((p.y - yMin[e]) * slope[e]));
+				inside ^= inSpan & left;
+			}
+			return inside != 0;
+		}
+
+		/** Points tested together against one edge */
+		enum { LANES = 16 };
+
+		/** inside[n] = 1 if points[n] is inside the polygon, else 0, for n in [begin..end).
+			Points are sorted by slab (counting sort, temporary buffers of end - begin entries),
+			then each slab is processed LANES points at a time. */
+		void TestRange(const Vec2D* points, u8* inside, u32 begin, u32 end) const {
+			if (end <= begin) { return; }
+			// Less than 4 edges per slab on average : the sort by slab costs more than it saves.
+			if (m_yMin.size() < (size_t)m_bucketCount * 4) {
+				for (u32 n = begin; n < end; n++) { inside[n] = Test(points[n]) ? 1 : 0; }
+				return;
+			}
+			const u32 count = end - begin;
+			std::vector<u32> slabStart(m_bucketCount + 1, 0);
+			std::vector<u32> pointSlab(count);
+			std::vector<u32> order(count);
+
+			// 1 - Slab of each point, points outside [minY..maxY) are done.
+			const u32 OUTSIDE = 0xFFFFFFFF;
+			for (u32 n = 0; n < count; n++) {
+				float y = points[begin + n].y;
+				if ((y < m_minY) || (y >= m_maxY)) {
+					inside[begin + n] = 0;
+					pointSlab[n] = OUTSIDE;
+				} else {
+					u32 bk = BucketIndex(y);
+					pointSlab[n] = bk;
+					slabStart[bk + 1]++;
+				}
+			}
+			for (u32 b = 0; b < m_bucketCount; b++) { slabStart[b + 1] += slabStart[b]; }
+
+			// 2 - Point indices sorted by slab.
+			std::vector<u32> cursor(slabStart.begin(), slabStart.end() - 1);
+			for (u32 n = 0; n < count; n++) {
+				if (pointSlab[n] != OUTSIDE) { order[cursor[pointSlab[n]]++] = begin + n; }
+			}
+
+			// 3 - LANES points of one slab against every edge of that slab.
+			const float* yMin	= &m_yMin[0];
+			const float* yMax	= &m_yMax[0];
+			const float* xAtMin	= &m_xAtMin[0];
+			const float* slope	= &m_slope[0];
+			for (u32 b = 0; b < m_bucketCount; b++) {
+				const u32 edgeBegin = m_bucketStart[b];
+				const u32 edgeEnd   = m_bucketStart[b + 1];
+				for (u32 s = slabStart[b]; s < slabStart[b + 1]; s += LANES) {
+					u32 valid = slabStart[b + 1] - s;
+					if (valid > LANES) { valid = LANES; }
+
+					// Missing lanes repeat the last point, their result is dropped.
+					float	px[LANES];
+					float	py[LANES];
+					u32		in[LANES];
+					for (u32 k = 0; k < LANES; k++) {
+						const Vec2D& p = points[order[s + ((k < valid) ? k : (valid - 1))]];
+						px[k] = p.x;
+						py[k] = p.y;
+						in[k] = 0;
+					}
+
+					for (u32 e = edgeBegin; e < edgeEnd; e++) {
+						const float y0 = yMin[e];
+						const float y1 = yMax[e];
+						const float x0 = xAtMin[e];
+						const float dx = slope[e];
+						// Same expression as Test(), on lanes : vectorized at -O2.
+						for (u32 k = 0; k < LANES; k++) {
+							u32 inSpan = (y0 <= py[k]) & (py[k] < y1);
+							u32 left   = px[k] < (x0 + ((py[k] - y0) * dx));
+							in[k] ^= inSpan & left;
+						}
+					}
+
+					for (u32 k = 0; k < valid; k++) { inside[order[s + k]] = (u8)in[k]; }
+				}
+			}
+		}
+
+		void TestBatch(const Vec2D* points, u32 count, u8* inside) const {
+			TestRange(points, inside, 0, count);
+		}
+
+		/** threadCount = 0 : lxParallel::DefaultThreadCount() */
+		void TestBatchParallel(const Vec2D* points, u32 count, u8* inside, u32 threadCount = 0) const {
+			const lxPolygonTester2D* self = this;
+			lxParallel::For(count, threadCount, [=](u32 begin, u32 end, u32) {
+				self->TestRange(points, inside, begin, end);
+			});
+		}
+
+	private:
+		enum { MAX_ENTRIES_PER_EDGE = 8 };
+
+		void SetBucketCount(u32 bucketCount) {
+			float height  = m_maxY - m_minY;
+			m_bucketCount = bucketCount;
+			m_bucketScale = (height > 0.0f) ? ((float)bucketCount / height) : 0.0f;
+		}
+
+		/** (edge, slab) entry count for the current buckets, outEdges : non horizontal edges */
+		u64 CountEntries(const Vec2D* polygon, u32 vertexCount, u64& outEdges) const {
+			u64 entries = 0;
+			outEdges = 0;
+			for (u32 i = 0, j = vertexCount - 1; i < vertexCount; j = i++) {
+				float ya = polygon[j].y;
+				float yb = polygon[i].y;
+				if (ya == yb) { continue; }
+				u32 first = BucketIndex((ya < yb) ? ya : yb);
+				u32 last  = BucketIndex((ya < yb) ? yb : ya);
+				entries += (last - first) + 1;
+				outEdges++;
+			}
+			return entries;
+		}
+
+		u32 BucketIndex(float y) const {
+			s32 b = (s32)((y - m_minY) * m_bucketScale);
+			if (b < 0)						{ b = 0; }
+			if (b >= (s32)m_bucketCount)	{ b = m_bucketCount - 1; }
+			return (u32)b;
+		}
+
+		float				m_minY;
+		float				m_maxY;
+		float				m_bucketScale;
+		u32					m_bucketCount;
+		std::vector<u32>	m_bucketStart;	// CSR : bucket b edges are [m_bucketStart[b] .. m_bucketStart[b+1])
+		std::vector<float>	m_yMin;
+		std::vector<float>	m_yMax;
+		std::vector<float>	m_xAtMin;
+		std::vector<float>	m_slope;		// dx / dy
+	};
+
+} // End namespace
+
+#endif // LX_GEOMETRY2D_H
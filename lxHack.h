@@ -47,6 +47,10 @@
 
 #include "lxTypes.h"
 
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
 #define optinline inline
  
 namespace lx {
@@ -264,6 +268,281 @@ namespace lx {
 			u32 mask = 1<<(bitPosition-1);
 			return ((x ^ mask) - mask);
 		}
+		
+		// -----------------------------------------------------------------
+		//   Bit deposit / extract (PDEP / PEXT)
+		//   deposit : scatter the low bits of x to the positions of the 1 bits of mask.
+		//   extract : gather the bits of x at the positions of the 1 bits of mask to the low bits.
+		//
+		//   3 implementations :
+		//   - deposit32/extract32			: portable, loop on the mask 1 bits (cost = popcount(mask)).
+		//   - lxBitMask32/64					: portable, 5 (6) steps of shift/mask precomputed from
+		//									  the mask (Hacker's Delight 7-4/7-5), for constant masks.
+		//   - deposit32_BMI2/extract32_BMI2	: single instruction, only when compiled with BMI2 (-mbmi2).
+		//									  Note : microcoded and slow on AMD before Zen 3.
+		//   depositFast/extractFast pick BMI2 when available, else the portable loop.
+		// -----------------------------------------------------------------
+		
+		optinline static
+		u32 deposit32(u32 x, u32 mask) {
+			u32 res = 0;
+			for (u32 bb = 1; mask; bb += bb) {
+				// -(x & bb) sets bit k (bb = 1<<k) and every bit above when source bit k is set, else 0.
+				// Enough : the k-th mask bit (lowest remaining one) is at a position >= k.
+				res  |= (mask & (0 - mask)) & (0 - (x & bb));
+				mask &= mask - 1;
+			}
+			return res;
+		}
+
+		optinline static
+		u32 extract32(u32 x, u32 mask) {
+			u32 res = 0;
+			for (u32 bb = 1; mask; bb += bb) {
+				if (x & mask & (0 - mask)) { res |= bb; }
+				mask &= mask - 1;
+			}
+			return res;
+		}
+
+		optinline static
+		u64 deposit64(u64 x, u64 mask) {
+			u64 res = 0;
+			for (u64 bb = 1; mask; bb += bb) {
+				res  |= (mask & (0 - mask)) & (0 - (x & bb));
+				mask &= mask - 1;
+			}
+			return res;
+		}
+
+		optinline static
+		u64 extract64(u64 x, u64 mask) {
+			u64 res = 0;
+			for (u64 bb = 1; mask; bb += bb) {
+				if (x & mask & (0 - mask)) { res |= bb; }
+				mask &= mask - 1;
+			}
+			return res;
+		}
+
+#if defined(__BMI2__)
+		#define LX_HAS_BMI2	(1)
+
+		optinline static
+		u32 deposit32_BMI2(u32 x, u32 mask)
+		{	return _pdep_u32(x, mask);		}
+
+		optinline static
+		u32 extract32_BMI2(u32 x, u32 mask)
+		{	return _pext_u32(x, mask);		}
+
+#if defined(__x86_64__) || defined(_M_X64)
+		optinline static
+		u64 deposit64_BMI2(u64 x, u64 mask)
+		{	return _pdep_u64(x, mask);		}
+
+		optinline static
+		u64 extract64_BMI2(u64 x, u64 mask)
+		{	return _pext_u64(x, mask);		}
+#else
+		optinline static
+		u64 deposit64_BMI2(u64 x, u64 mask) {
+			// 32 bit target : split in two halves.
+			u32 lowMask = (u32)mask;
+			return ((u64)_pdep_u32((u32)(x >> countOnes(lowMask)), (u32)(mask >> 32)) << 32)
+				 |       _pdep_u32((u32)x, lowMask);
+		}
+
+		optinline static
+		u64 extract64_BMI2(u64 x, u64 mask) {
+			u32 lowMask = (u32)mask;
+			return ((u64)_pext_u32((u32)(x >> 32), (u32)(mask >> 32)) << countOnes(lowMask))
+				 |       _pext_u32((u32)x, lowMask);
+		}
+#endif
+
+		optinline static u32 depositFast32(u32 x, u32 mask) { return deposit32_BMI2(x, mask); }
+		optinline static u32 extractFast32(u32 x, u32 mask) { return extract32_BMI2(x, mask); }
+		optinline static u64 depositFast64(u64 x, u64 mask) { return deposit64_BMI2(x, mask); }
+		optinline static u64 extractFast64(u64 x, u64 mask) { return extract64_BMI2(x, mask); }
+#else
+		optinline static u32 depositFast32(u32 x, u32 mask) { return deposit32(x, mask); }
+		optinline static u32 extractFast32(u32 x, u32 mask) { return extract32(x, mask); }
+		optinline static u64 depositFast64(u64 x, u64 mask) { return deposit64(x, mask); }
+		optinline static u64 extractFast64(u64 x, u64 mask) { return extract64(x, mask); }
+#endif
+
+		// Array versions : out[n] = op(in[n], mask). in and out may be the same buffer.
+
+		static
+		void deposit32Array(const u32* in, u32* out, u32 count, u32 mask)
+		{	for (u32 n = 0; n < count; n++) { out[n] = deposit32(in[n], mask); }		}
+
+		static
+		void extract32Array(const u32* in, u32* out, u32 count, u32 mask)
+		{	for (u32 n = 0; n < count; n++) { out[n] = extract32(in[n], mask); }		}
+
+		static
+		void deposit64Array(const u64* in, u64* out, u32 count, u64 mask)
+		{	for (u32 n = 0; n < count; n++) { out[n] = deposit64(in[n], mask); }		}
+
+		static
+		void extract64Array(const u64* in, u64* out, u32 count, u64 mask)
+		{	for (u32 n = 0; n < count; n++) { out[n] = extract64(in[n], mask); }		}
+
+		static
+		void depositFast32Array(const u32* in, u32* out, u32 count, u32 mask)
+		{	for (u32 n = 0; n < count; n++) { out[n] = depositFast32(in[n], mask); }	}
+
+		static
+		void extractFast32Array(const u32* in, u32* out, u32 count, u32 mask)
+		{	for (u32 n = 0; n < count; n++) { out[n] = extractFast32(in[n], mask); }	}
+
+		static
+		void depositFast64Array(const u64* in, u64* out, u32 count, u64 mask)
+		{	for (u32 n = 0; n < count; n++) { out[n] = depositFast64(in[n], mask); }	}
+
+		static
+		void extractFast64Array(const u64* in, u64* out, u32 count, u64 mask)
+		{	for (u32 n = 0; n < count; n++) { out[n] = extractFast64(in[n], mask); }	}
+
+		// -----------------------------------------------------------------
+		//   Bit interleave (Morton code), constant masks : shift & mask only.
+		// -----------------------------------------------------------------
+
+		/** Spread the 16 low bits of x to the even bits */
+		optinline static
+		u32 spreadBits16(u32 x) {
+			x &= 0x0000ffff;
+			x = (x | (x << 8)) & 0x00ff00ff;
+			x = (x | (x << 4)) & 0x0f0f0f0f;
+			x = (x | (x << 2)) & 0x33333333;
+			x = (x | (x << 1)) & 0x55555555;
+			return x;
+		}
+
+		/** Inverse of spreadBits16 : gather the even bits to the 16 low bits */
+		optinline static
+		u32 compactBits16(u32 x) {
+			x &= 0x55555555;
+			x = (x | (x >> 1)) & 0x33333333;
+			x = (x | (x >> 2)) & 0x0f0f0f0f;
+			x = (x | (x >> 4)) & 0x00ff00ff;
+			x = (x | (x >> 8)) & 0x0000ffff;
+			return x;
+		}
+
+		/** x bits on even positions, y bits on odd positions */
+		optinline static
+		u32 interleave2(u32 x, u32 y)
+		{	return spreadBits16(x) | (spreadBits16(y) << 1);	}
+
+		optinline static
+		void deinterleave2(u32 code, u32& x, u32& y)
+		{	x = compactBits16(code); y = compactBits16(code >> 1);	}
+	};
+	
+	// =================================================================
+	//   Precomputed deposit / extract for a constant mask.
+	//   Build once (log2(bits) steps), then each call is branchless and
+	//   only costs 5 (6) shift/and/or/xor groups whatever the mask popcount.
+	//   Hacker's Delight, 7-4 (compress) and 7-5 (expand).
+	// =================================================================
+	class lxBitMask32 {
+	public:
+		u32 mask;
+		u32 mv[5];
+
+		lxBitMask32(u32 m)
+		:mask(m)
+		{
+			u32 mk = ~m << 1;	// Count 0's to right.
+			for (int i = 0; i < 5; i++) {
+				u32 mp = mk ^ (mk << 1);	// Parallel suffix.
+				mp ^= (mp << 2);
+				mp ^= (mp << 4);
+				mp ^= (mp << 8);
+				mp ^= (mp << 16);
+				u32 v = mp & m;				// Bits to move.
+				mv[i] = v;
+				m  = (m ^ v) | (v >> (1 << i));
+				mk = mk & ~mp;
+			}
+		}
+
+		optinline
+		u32 extract(u32 x) const {
+			x &= mask;
+			for (int i = 0; i < 5; i++) {
+				u32 t = x & mv[i];
+				x = (x ^ t) | (t >> (1 << i));
+			}
+			return x;
+		}
+
+		optinline
+		u32 deposit(u32 x) const {
+			for (int i = 4; i >= 0; i--) {
+				u32 t = x << (1 << i);
+				x = (x & ~mv[i]) | (t & mv[i]);
+			}
+			return x & mask;
+		}
+
+		void extractArray(const u32* in, u32* out, u32 count) const
+		{	for (u32 n = 0; n < count; n++) { out[n] = extract(in[n]); }	}
+
+		void depositArray(const u32* in, u32* out, u32 count) const
+		{	for (u32 n = 0; n < count; n++) { out[n] = deposit(in[n]); }	}
+	};
+
+	class lxBitMask64 {
+	public:
+		u64 mask;
+		u64 mv[6];
+
+		lxBitMask64(u64 m)
+		:mask(m)
+		{
+			u64 mk = ~m << 1;
+			for (int i = 0; i < 6; i++) {
+				u64 mp = mk ^ (mk << 1);
+				mp ^= (mp << 2);
+				mp ^= (mp << 4);
+				mp ^= (mp << 8);
+				mp ^= (mp << 16);
+				mp ^= (mp << 32);
+				u64 v = mp & m;
+				mv[i] = v;
+				m  = (m ^ v) | (v >> (1 << i));
+				mk = mk & ~mp;
+			}
+		}
+
+		optinline
+		u64 extract(u64 x) const {
+			x &= mask;
+			for (int i = 0; i < 6; i++) {
+				u64 t = x & mv[i];
+				x = (x ^ t) | (t >> (1 << i));
+			}
+			return x;
+		}
+
+		optinline
+		u64 deposit(u64 x) const {
+			for (int i = 5; i >= 0; i--) {
+				u64 t = x << (1 << i);
+				x = (x & ~mv[i]) | (t & mv[i]);
+			}
+			return x & mask;
+		}
+
+		void extractArray(const u64* in, u64* out, u32 count) const
+		{	for (u32 n = 0; n < count; n++) { out[n] = extract(in[n]); }	}
+
+		void depositArray(const u64* in, u64* out, u32 count) const
+		{	for (u32 n = 0; n < count; n++) { out[n] = deposit(in[n]); }	}
 	};
 	
 	// =================================================================
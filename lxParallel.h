@@ -0,0 +1,63 @@
+/**
+	Minimal fork / join helper used by the batch functions of the library.
+
+	No pool, no task queue : the range is split in contiguous chunks,
+	one std::thread per chunk, the calling thread runs the last chunk and then joins.
+	Good enough for large batches (millions of elements) where thread start cost (~10-50 us) is noise.
+	For small batches call the range function directly instead.
+
+	Needs C++11 and linking with the platform thread library (-pthread).
+*/
+#ifndef LX_PARALLEL_H
+#define LX_PARALLEL_H
+
+#include <thread>
+#include <vector>
+#include "lxTypes.h"
+
+namespace lx {
+
+	class lxParallel {
+	public:
+		/** Hardware thread count, 1 if unknown */
+		static
+		u32 DefaultThreadCount() {
+			u32 n = std::thread::hardware_concurrency();
+			return n ? n : 1;
+		}
+
+		/** Call func(begin, end, threadIndex) on threadCount contiguous sub ranges of [0..count).
+			threadCount = 0 use DefaultThreadCount(). Sub ranges never overlap. */
+		template <class FUNC> static
+		void For(u32 count, u32 threadCount, FUNC func) {
+			if (threadCount == 0)		{ threadCount = DefaultThreadCount();	}
+			if (threadCount > count)	{ threadCount = count ? count : 1;		}
+
+			if (threadCount == 1) {
+				func(0, count, 0);
+				return;
+			}
+
+			std::vector<std::thread> threads;
+			threads.reserve(threadCount - 1);
+			u32 chunk = count / threadCount;
+			u32 extra = count % threadCount;
+			u32 begin = 0;
+			for (u32 t = 0; t < threadCount; t++) {
+				u32 end = begin + chunk + (t < extra ? 1 : 0);
+				if (t == threadCount - 1) {
+					func(begin, end, t);
+				} else {
+					threads.push_back(std::thread(func, begin, end, t));
+				}
+				begin = end;
+			}
+			for (u32 t = 0; t < threads.size(); t++) {
+				threads[t].join();
+			}
+		}
+	};
+
+} // End namespace
+
+#endif // LX_PARALLEL_H
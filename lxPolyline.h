@@ -0,0 +1,515 @@
+/**
+	Polyline simplification for Vec2D / Vec3D.
+
+	- Ramer-Douglas-Peucker : keep vertices further than epsilon from the simplified segment.
+	  Explicit stack (no recursion, no stack overflow on millions of vertices).
+	  Segment data (start, direction, 1/length^2) is computed once per sub range, and the
+	  farthest vertex search runs over blocks of squared distances, instead of calling
+	  GetProjectionPosFactor / GetPoint / SqrDistancePointPoint per vertex.
+	  Both passes of a block (distances, then block maximum) are branch free and GCC vectorizes them
+	  at -O2 without -ffast-math (check with -fopt-info-vec) :
+	  Vec2D with plain SSE2, Vec3D needs -msse4.1 or better on x86 (stride 3 loads + pminsd).
+	- RDP parallel : the first levels are split by the calling thread (big scans are themselves
+	  split across threads), then the independent sub ranges are simplified by all threads.
+	- Visvalingam-Whyatt : remove the vertex forming the smallest triangle area until all
+	  remaining triangles are bigger than minArea. Min heap, O(n log n).
+	- lxPolylineStream : unbounded input simplified by fixed size windows, memory is O(window).
+
+	Distances are point to segment (projection clamped to [0..1]), compared squared.
+	Results are given as a keep flag per vertex (xxxMark) or as a compacted copy. First and last
+	vertices are always kept.
+*/
+#ifndef LX_POLYLINE_H
+#define LX_POLYLINE_H
+
+#include <math.h>
+#include <string.h>		// memcpy for float bits.
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include "lxVectors.h"	// And includes lxHack.h, lxTypes.h
+#include "lxParallel.h"
+
+namespace lx {
+
+	// =================================================================
+	//   Branch free helpers on float bits.
+	//   A float compare inside a loop is kept as control flow (-ftrapping-math),
+	//   the same compare done on the integer bits is a plain vector min / max.
+	// =================================================================
+	class lxPolylineMath {
+	public:
+		/** Clamp t to [0..1] */
+		optinline static
+		float Clamp01(float t) {
+			union { float f; s32 i; } u;
+			u.f  = t;
+			u.i &= ~(u.i >> 31);								// Negative -> +0.0f
+			u.i  = (u.i < 0x3F800000) ? u.i : 0x3F800000;		// Positive floats order as integers (see lxFloat::ComparePositiveOnly_lessThan)
+			return u.f;
+		}
+	};
+
+	// =================================================================
+	//   Per vector type helpers.
+	// =================================================================
+	template <class VEC> class lxPolylineTraits;
+
+	template <> class lxPolylineTraits<Vec2D> {
+	public:
+		/** Squared distance to segment [a,b], constants hoisted out of the vertex loop */
+		class Segment {
+		public:
+			Segment(const Vec2D& a, const Vec2D& b)
+			:ax(a.x), ay(a.y), dx(b.x - a.x), dy(b.y - a.y)
+			{
+				float lengthSqr = (dx * dx) + (dy * dy);
+				invLengthSqr = (lengthSqr > 0.0f) ? (1.0f / lengthSqr) : 0.0f;	// Degenerated : distance to a.
+			}
+
+			optinline
+			float SqrDistance(const Vec2D& p) const {
+				float px = p.x - ax;
+				float py = p.y - ay;
+				float t  = ((px * dx) + (py * dy)) * invLengthSqr;
+				t = lxPolylineMath::Clamp01(t);
+				float ex = px - (dx * t);
+				float ey = py - (dy * t);
+				return (ex * ex) + (ey * ey);
+			}
+
+			float ax, ay, dx, dy, invLengthSqr;
+		};
+
+		optinline static
+		float TriangleArea(const Vec2D& a, const Vec2D& b, const Vec2D& c)
+		{	return 0.5f * fabsf(Vec2D::Orientation(a, b, c));	}
+	};
+
+	template <> class lxPolylineTraits<Vec3D> {
+	public:
+		class Segment {
+		public:
+			Segment(const Vec3D& a, const Vec3D& b)
+			:ax(a.x), ay(a.y), az(a.z), dx(b.x - a.x), dy(b.y - a.y), dz(b.z - a.z)
+			{
+				float lengthSqr = (dx * dx) + (dy * dy) + (dz * dz);
+				invLengthSqr = (lengthSqr > 0.0f) ? (1.0f / lengthSqr) : 0.0f;
+			}
+
+			optinline
+			float SqrDistance(const Vec3D& p) const {
+				float px = p.x - ax;
+				float py = p.y - ay;
+				float pz = p.z - az;
+				float t  = ((px * dx) + (py * dy) + (pz * dz)) * invLengthSqr;
+				t = lxPolylineMath::Clamp01(t);
+				float ex = px - (dx * t);
+				float ey = py - (dy * t);
+				float ez = pz - (dz * t);
+				return (ex * ex) + (ey * ey) + (ez * ez);
+			}
+
+			float ax, ay, az, dx, dy, dz, invLengthSqr;
+		};
+
+		optinline static
+		float TriangleArea(const Vec3D& a, const Vec3D& b, const Vec3D& c) {
+			// Vec3D::Cross modifies the vector, done by hand.
+			float ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z;
+			float vx = c.x - a.x, vy = c.y - a.y, vz = c.z - a.z;
+			float cx = (uy * vz) - (uz * vy);
+			float cy = (uz * vx) - (ux * vz);
+			float cz = (ux * vy) - (uy * vx);
+			return 0.5f * sqrtf((cx * cx) + (cy * cy) + (cz * cz));
+		}
+	};
+
+	// =================================================================
+	//   Simplification algorithms.
+	// =================================================================
+	template <class VEC>
+	class lxPolylineSimplifier {
+	public:
+		typedef typename lxPolylineTraits<VEC>::Segment Segment;
+
+		/** Farthest vertex of [begin..end[ from segment, first one on ties.
+			outIndex = begin - 1 and outSqrDist = -1 when the range is empty. */
+		static
+		void FarthestVertexInSlice(const Segment& segment, const VEC* points, u32 begin, u32 end, u32& outIndex, float& outSqrDist) {
+			enum { BLOCK = 64 };
+			// Squared distances are >= 0 : their bits compare as s32, integer max needs no branch.
+			union { float f[BLOCK]; s32 i[BLOCK]; } dist;
+			s32		best		= -1;
+			u32		bestIndex	= begin - 1;
+			u32		i			= begin;
+			for (; i + BLOCK <= end; i += BLOCK) {
+				// Constant trip count, no branch : vectorized at -O2.
+				// (Block pointer : 'points[i + k]' with u32 wrap around is not an affine access for GCC.)
+				const VEC* block = &points[i];
+				for (u32 k = 0; k < BLOCK; k++) {
+					dist.f[k] = segment.SqrDistance(block[k]);
+				}
+				s32 blockMax = -1;
+				for (u32 k = 0; k < BLOCK; k++) {
+					blockMax = (dist.i[k] > blockMax) ? dist.i[k] : blockMax;
+				}
+				// Index search only when the block holds a new maximum.
+				if (blockMax > best) {
+					for (u32 k = 0; k < BLOCK; k++) {
+						if (dist.i[k] == blockMax) { bestIndex = i + k; break; }
+					}
+					best = blockMax;
+				}
+			}
+			// Tail (< BLOCK vertices).
+			for (; i < end; i++) {
+				float	d = segment.SqrDistance(points[i]);
+				s32		b;
+				memcpy(&b, &d, sizeof(s32));
+				if (b > best) { best = b; bestIndex = i; }
+			}
+			outIndex = bestIndex;
+			if (best < 0) {
+				outSqrDist = -1.0f;
+			} else {
+				memcpy(&outSqrDist, &best, sizeof(float));
+			}
+		}
+
+		/** Farthest vertex of ]first..last[ from segment [first,last] */
+		static
+		void FarthestVertex(const VEC* points, u32 first, u32 last, u32& outIndex, float& outSqrDist) {
+			const Segment segment(points[first], points[last]);
+			FarthestVertexInSlice(segment, points, first + 1, last, outIndex, outSqrDist);
+		}
+
+		/** RDP on [first..last], only writes keep[] inside ]first..last[ (set to 1, never cleared).
+			stack is a work buffer, reused between calls. Return the number of vertices set. */
+		static
+		u32 RDPRange(const VEC* points, u32 first, u32 last, float epsilonSqr, u8* keep, std::vector<u32>& stack) {
+			u32 kept = 0;
+			stack.clear();
+			stack.push_back(first);
+			stack.push_back(last);
+			while (!stack.empty()) {
+				u32 e = stack.back(); stack.pop_back();
+				u32 s = stack.back(); stack.pop_back();
+				if (e - s < 2) { continue; }
+
+				u32		index;
+				float	sqrDist;
+				FarthestVertex(points, s, e, index, sqrDist);
+				if (sqrDist > epsilonSqr) {
+					keep[index] = 1;
+					kept++;
+					stack.push_back(s);		stack.push_back(index);
+					stack.push_back(index);	stack.push_back(e);
+				}
+			}
+			return kept;
+		}
+
+		/** keep[n] = 1 if vertex n is kept, else 0. Return the kept vertex count. */
+		static
+		u32 RDPMark(const VEC* points, u32 count, float epsilon, u8* keep) {
+			if (count == 0) { return 0; }
+			for (u32 n = 0; n < count; n++) { keep[n] = 0; }
+			keep[0]			= 1;
+			keep[count - 1]	= 1;
+			if (count < 3) { return count; }
+
+			std::vector<u32> stack;
+			stack.reserve(128);
+			return 2 + RDPRange(points, 0, count - 1, epsilon * epsilon, keep, stack);
+		}
+
+		/** Same result as RDPMark. threadCount = 0 : lxParallel::DefaultThreadCount() */
+		static
+		u32 RDPMarkParallel(const VEC* points, u32 count, float epsilon, u8* keep, u32 threadCount = 0) {
+			if (threadCount == 0) { threadCount = lxParallel::DefaultThreadCount(); }
+			if ((threadCount == 1) || (count < PARALLEL_MIN_COUNT)) {
+				return RDPMark(points, count, epsilon, keep);
+			}
+
+			const float epsilonSqr = epsilon * epsilon;
+			lxParallel::For(count, threadCount, [=](u32 begin, u32 end, u32) {
+				for (u32 n = begin; n < end; n++) { keep[n] = 0; }
+			});
+			keep[0]			= 1;
+			keep[count - 1]	= 1;
+			u32 kept = 2;
+
+			// 1 - Split big ranges on this thread until there is enough independent work.
+			//     Ranges are pairs (first, last), endpoints already marked.
+			std::vector<u32> pending;
+			std::vector<u32> ready;
+			pending.push_back(0);
+			pending.push_back(count - 1);
+			const u32 targetRanges = threadCount * 8;
+			const u32 minSplitSize = count / targetRanges;
+			while (!pending.empty()) {
+				u32 e = pending.back(); pending.pop_back();
+				u32 s = pending.back(); pending.pop_back();
+				if (e - s < 2) { continue; }
+				if ((e - s < minSplitSize) || ((ready.size() / 2) + (pending.size() / 2) >= targetRanges)) {
+					ready.push_back(s);
+					ready.push_back(e);
+					continue;
+				}
+
+				u32		index;
+				float	sqrDist;
+				FarthestVertexParallel(points, s, e, threadCount, index, sqrDist);
+				if (sqrDist > epsilonSqr) {
+					keep[index] = 1;
+					kept++;
+					pending.push_back(s);		pending.push_back(index);
+					pending.push_back(index);	pending.push_back(e);
+				}
+			}
+
+			// 2 - Biggest ranges first, threads grab the next range from a shared counter.
+			u32 rangeCount = (u32)(ready.size() / 2);
+			std::vector<u32> order(rangeCount);
+			for (u32 r = 0; r < rangeCount; r++) { order[r] = r; }
+			const u32* rd = rangeCount ? &ready[0] : NULL;
+			std::sort(order.begin(), order.end(), [=](u32 a, u32 b) {
+				return (rd[a * 2 + 1] - rd[a * 2]) > (rd[b * 2 + 1] - rd[b * 2]);
+			});
+
+			const u32*			ord		= rangeCount ? &order[0] : NULL;
+			std::atomic<u32>	next(0);
+			std::atomic<u32>	keptInRanges(0);
+			std::atomic<u32>*	pNext	= &next;
+			std::atomic<u32>*	pKept	= &keptInRanges;
+			lxParallel::For(threadCount, threadCount, [=](u32, u32, u32) {
+				std::vector<u32> stack;
+				u32 localKept = 0;
+				for (u32 r = pNext->fetch_add(1); r < rangeCount; r = pNext->fetch_add(1)) {
+					u32 id = ord[r];
+					// Ranges only share endpoints (already set) : writes to keep[] never overlap.
+					localKept += RDPRange(points, rd[id * 2], rd[id * 2 + 1], epsilonSqr, keep, stack);
+				}
+				pKept->fetch_add(localKept);
+			});
+			return kept + keptInRanges.load();
+		}
+
+		/** Visvalingam-Whyatt. Vertices forming a triangle of area < minArea are removed, smallest first.
+			A neighbor area never drops under the area just removed (keeps the removal order monotonic). */
+		static
+		u32 VisvalingamMark(const VEC* points, u32 count, float minArea, u8* keep) {
+			for (u32 n = 0; n < count; n++) { keep[n] = 1; }
+			if (count < 3) { return count; }
+
+			std::vector<u32>	prev(count);
+			std::vector<u32>	next(count);
+			std::vector<float>	area(count);
+			std::vector<u32>	heap;			// Interior vertex ids, min heap on area.
+			std::vector<u32>	heapPos(count);	// Vertex id -> heap position.
+			heap.reserve(count - 2);
+			for (u32 n = 1; n < count - 1; n++) {
+				prev[n]		= n - 1;
+				next[n]		= n + 1;
+				area[n]		= lxPolylineTraits<VEC>::TriangleArea(points[n - 1], points[n], points[n + 1]);
+				heapPos[n]	= (u32)heap.size();
+				heap.push_back(n);
+			}
+			for (u32 h = (u32)(heap.size() / 2); h > 0; h--) { SiftDown(heap, heapPos, area, h - 1); }
+
+			u32 kept = count;
+			while (!heap.empty()) {
+				u32 v = heap[0];
+				float removedArea = area[v];
+				if (removedArea >= minArea) { break; }
+
+				// Pop.
+				heap[0]				= heap.back();
+				heapPos[heap[0]]	= 0;
+				heap.pop_back();
+				if (!heap.empty()) { SiftDown(heap, heapPos, area, 0); }
+
+				keep[v] = 0;
+				kept--;
+				u32 p = prev[v];
+				u32 q = next[v];
+				next[p] = q;
+				prev[q] = p;
+
+				// Update the two neighbors (endpoints 0 and count-1 are not in the heap).
+				if (p != 0) {
+					float a = lxPolylineTraits<VEC>::TriangleArea(points[prev[p]], points[p], points[q]);
+					UpdateArea(heap, heapPos, area, p, (a < removedArea) ? removedArea : a);
+				}
+				if (q != count - 1) {
+					float a = lxPolylineTraits<VEC>::TriangleArea(points[p], points[q], points[next[q]]);
+					UpdateArea(heap, heapPos, area, q, (a < removedArea) ? removedArea : a);
+				}
+			}
+			return kept;
+		}
+
+		/** Copy kept vertices to out (in order), return the count. out may be points (in place). */
+		static
+		u32 Compact(const VEC* points, u32 count, const u8* keep, VEC* out) {
+			u32 w = 0;
+			for (u32 n = 0; n < count; n++) {
+				if (keep[n]) { out[w++] = points[n]; }
+			}
+			return w;
+		}
+
+		static
+		u32 RDP(const VEC* points, u32 count, float epsilon, VEC* out, u32 threadCount = 1) {
+			std::vector<u8> keep(count);
+			if (count == 0) { return 0; }
+			RDPMarkParallel(points, count, epsilon, &keep[0], threadCount);
+			return Compact(points, count, &keep[0], out);
+		}
+
+		static
+		u32 Visvalingam(const VEC* points, u32 count, float minArea, VEC* out) {
+			std::vector<u8> keep(count);
+			if (count == 0) { return 0; }
+			VisvalingamMark(points, count, minArea, &keep[0]);
+			return Compact(points, count, &keep[0], out);
+		}
+
+		enum { PARALLEL_MIN_COUNT = 65536 };
+
+	private:
+		static
+		void FarthestVertexParallel(const VEC* points, u32 first, u32 last, u32 threadCount, u32& outIndex, float& outSqrDist) {
+			if (last - first < PARALLEL_MIN_COUNT) {
+				FarthestVertex(points, first, last, outIndex, outSqrDist);
+				return;
+			}
+			// Each thread scans a slice with the same segment, then keep the best slice.
+			std::vector<u32>	index(threadCount, first);
+			std::vector<float>	dist (threadCount, -1.0f);
+			u32*	pIndex	= &index[0];
+			float*	pDist	= &dist[0];
+			const Segment segment(points[first], points[last]);
+			const Segment* pSegment = &segment;
+			lxParallel::For(last - first - 1, threadCount, [=](u32 begin, u32 end, u32 t) {
+				FarthestVertexInSlice(*pSegment, points, first + 1 + begin, first + 1 + end, pIndex[t], pDist[t]);
+			});
+			outIndex	= first;
+			outSqrDist	= -1.0f;
+			for (u32 t = 0; t < threadCount; t++) {
+				if (dist[t] > outSqrDist) { outSqrDist = dist[t]; outIndex = index[t]; }
+			}
+		}
+
+		static
+		void SiftDown(std::vector<u32>& heap, std::vector<u32>& heapPos, const std::vector<float>& area, u32 pos) {
+			u32 size = (u32)heap.size();
+			u32 v    = heap[pos];
+			for (;;) {
+				u32 child = (pos * 2) + 1;
+				if (child >= size) { break; }
+				if ((child + 1 < size) && (area[heap[child + 1]] < area[heap[child]])) { child++; }
+				if (area[heap[child]] >= area[v]) { break; }
+				heap[pos] = heap[child];
+				heapPos[heap[pos]] = pos;
+				pos = child;
+			}
+			heap[pos]  = v;
+			heapPos[v] = pos;
+		}
+
+		static
+		void SiftUp(std::vector<u32>& heap, std::vector<u32>& heapPos, const std::vector<float>& area, u32 pos) {
+			u32 v = heap[pos];
+			while (pos > 0) {
+				u32 parent = (pos - 1) / 2;
+				if (area[heap[parent]] <= area[v]) { break; }
+				heap[pos] = heap[parent];
+				heapPos[heap[pos]] = pos;
+				pos = parent;
+			}
+			heap[pos]  = v;
+			heapPos[v] = pos;
+		}
+
+		static
+		void UpdateArea(std::vector<u32>& heap, std::vector<u32>& heapPos, std::vector<float>& area, u32 v, float newArea) {
+			float old = area[v];
+			area[v] = newArea;
+			if (newArea < old)	{ SiftUp  (heap, heapPos, area, heapPos[v]); }
+			else				{ SiftDown(heap, heapPos, area, heapPos[v]); }
+		}
+	};
+
+	// =================================================================
+	//   Streaming RDP.
+	//   Points are accumulated into a window of windowSize vertices.
+	//   When full, the window is simplified, kept vertices are output
+	//   except the last one which starts the next window.
+	//   Window boundaries are always kept : result may have a few more
+	//   vertices than a global RDP, never a vertex further than epsilon.
+	// =================================================================
+	template <class VEC>
+	class lxPolylineStream {
+	public:
+		lxPolylineStream(u32 windowSize, float epsilon)
+		:m_windowSize(windowSize < 3 ? 3 : windowSize)
+		,m_epsilon(epsilon)
+		{
+			m_window.reserve(m_windowSize);
+			m_keep  .resize (m_windowSize);
+			m_stack .reserve(128);
+		}
+
+		u32 GetWindowSize() const { return m_windowSize; }
+
+		/** Add one vertex. out must hold GetWindowSize() vertices, return the number written (often 0). */
+		u32 Push(const VEC& point, VEC* out) {
+			m_window.push_back(point);
+			if (m_window.size() < m_windowSize) { return 0; }
+
+			u32 written = SimplifyWindow(out, false);
+			VEC last = m_window.back();
+			m_window.clear();
+			m_window.push_back(last);
+			return written;
+		}
+
+		/** End of input : output the remaining vertices, including the last one. Stream can be reused after. */
+		u32 Flush(VEC* out) {
+			u32 written = SimplifyWindow(out, true);
+			m_window.clear();
+			return written;
+		}
+
+	private:
+		u32 SimplifyWindow(VEC* out, bool withLast) {
+			u32 count = (u32)m_window.size();
+			if (count == 0) { return 0; }
+			u8* keep = &m_keep[0];
+			for (u32 n = 0; n < count; n++) { keep[n] = 0; }
+			keep[0]			= 1;
+			keep[count - 1]	= 1;
+			if (count >= 3) {
+				lxPolylineSimplifier<VEC>::RDPRange(&m_window[0], 0, count - 1, m_epsilon * m_epsilon, keep, m_stack);
+			}
+			if (!withLast) { keep[count - 1] = 0; }
+			return lxPolylineSimplifier<VEC>::Compact(&m_window[0], count, keep, out);
+		}
+
+		u32					m_windowSize;
+		float				m_epsilon;
+		std::vector<VEC>	m_window;
+		std::vector<u8>		m_keep;
+		std::vector<u32>	m_stack;
+	};
+
+	typedef lxPolylineSimplifier<Vec2D>	lxPolylineSimplifier2D;
+	typedef lxPolylineSimplifier<Vec3D>	lxPolylineSimplifier3D;
+	typedef lxPolylineStream<Vec2D>		lxPolylineStream2D;
+	typedef lxPolylineStream<Vec3D>		lxPolylineStream3D;
+
+} // End namespace
+
+#endif // LX_POLYLINE_H
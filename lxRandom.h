@@ -0,0 +1,328 @@
+/**
+	Pseudo random generators.
+
+	Small state, integer only generators meant to replace rand() / <random>
+	in hot loops (Monte Carlo jitter, sampling, noise).
+
+	- lxXorShift32			: 32 bit state, smallest and fastest, lowest quality.
+	- lxPCG32				: 64 bit state, 2^63 independent streams selected at construction.
+	- lxXoshiro128Plus		: 128 bit state, Jump() give non overlapping sub-sequences of 2^64.
+	- lxXoshiro128PlusN<N>	: N independent xoshiro128+ streams stored as SoA,
+							  one call produces N values. Lane loops are written so the compiler
+							  can map them to SSE2 / AVX2 / NEON registers (4 or 8 lanes).
+
+	Threading :
+	Generators own their state, nothing is shared.
+	Give each thread its own instance with a different streamIndex.
+
+	Float conversion use the exponent injection trick (see lxFloat::ApproxInverseA) :
+	23 random bits are put into the mantissa of 1.0f (0x3F800000), giving [1..2) ,
+	then 1.0f is substracted giving [0..1) with a 2^-23 step.
+	No int to float conversion, no divide.
+	(Done through a union : GCC -O2 strict aliasing may drop the pointer cast version store.)
+*/
+#ifndef LX_RANDOM_H
+#define LX_RANDOM_H
+
+#include <math.h>
+#include "lxVectors.h"	// And includes lxHack.h, lxTypes.h
+
+namespace lx {
+
+	// =================================================================
+	//   Conversion & seeding helpers
+	// =================================================================
+	class lxRandom {
+	public:
+		/** Uniform float in [0..1) from the upper 23 bits of a 32 bit random value */
+		optinline static
+		float BitsToUnitFloat(u32 bits) {
+			union { u32 i; float f; } u;
+			u.i = (bits >> 9) | 0x3F800000;
+			return u.f - 1.0f;
+		}
+
+		/** Uniform float in [-1..1) from the upper 23 bits of a 32 bit random value */
+		optinline static
+		float BitsToSignedUnitFloat(u32 bits) {
+			// [2..4) - 3
+			union { u32 i; float f; } u;
+			u.i = (bits >> 9) | 0x40000000;
+			return u.f - 3.0f;
+		}
+
+		/** SplitMix32 (Murmur3 finalizer on a Weyl sequence), used to expand a single seed into generator state */
+		optinline static
+		u32 SplitMix32(u32& state) {
+			u32 z = (state += 0x9E3779B9);
+			z = (z ^ (z >> 16)) * 0x85EBCA6B;
+			z = (z ^ (z >> 13)) * 0xC2B2AE35;
+			return z ^ (z >> 16);
+		}
+
+		optinline static
+		u32 Rotl(u32 x, u32 k)
+		{	return (x << k) | (x >> (32 - k));	}
+	};
+
+	// =================================================================
+	//   XorShift32 (Marsaglia)
+	//   Period 2^32-1, state must never be 0.
+	// =================================================================
+	class lxXorShift32 {
+	public:
+		u32 state;
+
+		lxXorShift32(u32 seed) {
+			u32 s = seed;
+			state = lxRandom::SplitMix32(s);
+			if (state == 0) { state = 0x6C078965; }
+		}
+
+		inline u32 Next() {
+			u32 x = state;
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			state = x;
+			return x;
+		}
+
+		inline float NextFloat()
+		{	return lxRandom::BitsToUnitFloat(Next());	}
+	};
+
+	// =================================================================
+	//   PCG32 (O'Neill, XSH RR 64/32)
+	//   Period 2^64, streamIndex select one of 2^63 independent sequences.
+	// =================================================================
+	class lxPCG32 {
+	public:
+		u64 state;
+		u64 inc;
+
+		lxPCG32(u64 seed, u64 streamIndex = 0)
+		:state(0)
+		,inc((streamIndex << 1) | 1)
+		{
+			Next();
+			state += seed;
+			Next();
+		}
+
+		inline u32 Next() {
+			u64 old = state;
+			state = old * 6364136223846793005ULL + inc;
+			u32 xorShifted = (u32)(((old >> 18) ^ old) >> 27);
+			u32 rot        = (u32)(old >> 59);
+			return (xorShifted >> rot) | (xorShifted << ((0 - rot) & 31));
+		}
+
+		inline float NextFloat()
+		{	return lxRandom::BitsToUnitFloat(Next());	}
+	};
+
+	// =================================================================
+	//   Xoshiro128+ (Blackman & Vigna)
+	//   Period 2^128-1. Lower bits are weak, upper bits are fine for floats.
+	// =================================================================
+	class lxXoshiro128Plus {
+	public:
+		u32 s[4];
+
+		/** streamIndex : number of Jump() applied, each stream is 2^64 values long */
+		lxXoshiro128Plus(u32 seed, u32 streamIndex = 0) {
+			u32 sm = seed;
+			s[0] = lxRandom::SplitMix32(sm);
+			s[1] = lxRandom::SplitMix32(sm);
+			s[2] = lxRandom::SplitMix32(sm);
+			s[3] = lxRandom::SplitMix32(sm);
+			for (u32 n = 0; n < streamIndex; n++) { Jump(); }
+		}
+
+		inline u32 Next() {
+			const u32 result = s[0] + s[3];
+			const u32 t = s[1] << 9;
+			s[2] ^= s[0];
+			s[3] ^= s[1];
+			s[1] ^= s[2];
+			s[0] ^= s[3];
+			s[2] ^= t;
+			s[3]  = lxRandom::Rotl(s[3], 11);
+			return result;
+		}
+
+		inline float NextFloat()
+		{	return lxRandom::BitsToUnitFloat(Next());	}
+
+		/** Equivalent to 2^64 calls to Next() */
+		void Jump() {
+			static const u32 JUMP[4] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+			u32 s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+			for (int i = 0; i < 4; i++) {
+				for (int b = 0; b < 32; b++) {
+					if (JUMP[i] & (1U << b)) {
+						s0 ^= s[0];
+						s1 ^= s[1];
+						s2 ^= s[2];
+						s3 ^= s[3];
+					}
+					Next();
+				}
+			}
+			s[0] = s0; s[1] = s1; s[2] = s2; s[3] = s3;
+		}
+	};
+
+	// =================================================================
+	//   Xoshiro128+ , LANES parallel streams.
+	//   State is stored as SoA so that each step is 8 vector operations
+	//   for all lanes at once. LANES = 4 (SSE2 / NEON) or 8 (AVX2).
+	//
+	//   Lane L of stream S is the scalar generator jumped (S * LANES + L) times :
+	//   two instances with different streamIndex never overlap.
+	// =================================================================
+	template <int LANES>
+	class lxXoshiro128PlusN {
+	public:
+		u32 s0[LANES];
+		u32 s1[LANES];
+		u32 s2[LANES];
+		u32 s3[LANES];
+
+		lxXoshiro128PlusN(u32 seed, u32 streamIndex = 0) {
+			lxXoshiro128Plus gen(seed);
+			for (u32 n = 0; n < streamIndex * LANES; n++) { gen.Jump(); }
+			for (int l = 0; l < LANES; l++) {
+				s0[l] = gen.s[0];
+				s1[l] = gen.s[1];
+				s2[l] = gen.s[2];
+				s3[l] = gen.s[3];
+				gen.Jump();
+			}
+		}
+
+		/** Write LANES random values into out */
+		inline void Next(u32* out) {
+			for (int l = 0; l < LANES; l++) {
+				const u32 result = s0[l] + s3[l];
+				const u32 t = s1[l] << 9;
+				s2[l] ^= s0[l];
+				s3[l] ^= s1[l];
+				s1[l] ^= s2[l];
+				s0[l] ^= s3[l];
+				s2[l] ^= t;
+				s3[l]  = (s3[l] << 11) | (s3[l] >> 21);
+				out[l] = result;
+			}
+		}
+
+		/** Write LANES uniform floats in [0..1) into out */
+		inline void NextFloat(float* out) {
+			u32 bits[LANES];
+			Next(bits);
+			for (int l = 0; l < LANES; l++) {
+				union { u32 i; float f; } u;
+				u.i = (bits[l] >> 9) | 0x3F800000;
+				out[l] = u.f - 1.0f;
+			}
+		}
+
+		/** Write LANES uniform floats in [-1..1) into out */
+		inline void NextSignedFloat(float* out) {
+			u32 bits[LANES];
+			Next(bits);
+			for (int l = 0; l < LANES; l++) {
+				union { u32 i; float f; } u;
+				u.i = (bits[l] >> 9) | 0x40000000;
+				out[l] = u.f - 3.0f;
+			}
+		}
+
+		// -------------------------------------------------------------
+		//   Batch helpers
+		// -------------------------------------------------------------
+
+		/** Uniform floats in [0..1) */
+		void FillUniform(float* out, u32 count) {
+			u32 n = 0;
+			for (; n + LANES <= count; n += LANES) {
+				NextFloat(&out[n]);
+			}
+			if (n < count) {
+				float tmp[LANES];
+				NextFloat(tmp);
+				for (int l = 0; (l < LANES) && (n < count); n++, l++) { out[n] = tmp[l]; }
+			}
+		}
+
+		/** Normal distribution using Box-Muller, each pair of uniforms gives two gaussians */
+		void FillGaussian(float* out, u32 count, float mean = 0.0f, float sigma = 1.0f) {
+			const float TWO_PI = 6.28318530717958647692f;
+			float u[LANES];
+			float v[LANES];
+			u32 n = 0;
+			while (n < count) {
+				NextFloat(u);
+				NextFloat(v);
+				for (int l = 0; (l < LANES) && (n < count); l++) {
+					// 1-u in (0..1] : log never get 0.
+					float r     = sigma * sqrtf(-2.0f * logf(1.0f - u[l]));
+					float theta = TWO_PI * v[l];
+					out[n++] = mean + r * cosf(theta);
+					if (n < count) { out[n++] = mean + r * sinf(theta); }
+				}
+			}
+		}
+
+		/** Uniform points inside the unit disk, rejection from the [-1..1) square (~78.5% accepted) */
+		void FillUnitDisk(Vec2D* out, u32 count) {
+			float x[LANES];
+			float y[LANES];
+			u32 n = 0;
+			while (n < count) {
+				NextSignedFloat(x);
+				NextSignedFloat(y);
+				for (int l = 0; (l < LANES) && (n < count); l++) {
+					if ((x[l] * x[l]) + (y[l] * y[l]) < 1.0f) {
+						out[n].x = x[l];
+						out[n].y = y[l];
+						n++;
+					}
+				}
+			}
+		}
+
+		/** Uniform points on the unit sphere surface.
+			Rejection inside the unit ball (~52% accepted) then projection with Vec3D::NormalizeApprox.
+			Radius error is the one of lxFloat::ApproxReciproqualSQRT (< 0.175%). */
+		void FillUnitSphere(Vec3D* out, u32 count) {
+			float x[LANES];
+			float y[LANES];
+			float z[LANES];
+			u32 n = 0;
+			while (n < count) {
+				NextSignedFloat(x);
+				NextSignedFloat(y);
+				NextSignedFloat(z);
+				for (int l = 0; (l < LANES) && (n < count); l++) {
+					float lengthSqr = (x[l] * x[l]) + (y[l] * y[l]) + (z[l] * z[l]);
+					// Reject the center too : direction is undefined.
+					if ((lengthSqr < 1.0f) && (lengthSqr > 1.0e-6f)) {
+						Vec3D p = Vec3D(x[l], y[l], z[l]).NormalizeApprox();
+						out[n].x = p.x;
+						out[n].y = p.y;
+						out[n].z = p.z;
+						n++;
+					}
+				}
+			}
+		}
+	};
+
+	typedef lxXoshiro128PlusN<4>	lxXoshiro128Plus_x4;
+	typedef lxXoshiro128PlusN<8>	lxXoshiro128Plus_x8;
+
+} // End namespace
+
+#endif // LX_RANDOM_H
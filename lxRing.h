@@ -0,0 +1,297 @@
+/**
+	Lock free bounded ring buffers.
+
+	- lxSPSCRing<T>	: one producer thread, one consumer thread. Wait free.
+	- lxMPMCRing<T>	: any number of producers and consumers (D. Vyukov bounded queue),
+					  one CAS per operation, no lock, no allocation after construction.
+
+	Capacity is a power of 2 (rounded up with lxUnsignedInt32::ui_closestPowerOf2 if needed) :
+	indices are free running u32 counters, slot = ui_moduloPower2(index, capacity),
+	wrap around of the counter is harmless because capacity divides 2^32.
+
+	Zero copy :
+	Besides TryPush / TryPop (copy of T), each ring gives direct access to its slots :
+		T* slot = ring.TryAcquireWrite(...);  fill *slot in place;  ring.CommitWrite(...);
+		T* slot = ring.TryAcquireRead(...);   use *slot in place;   ring.ReleaseRead(...);
+	With T = lxVec3DBatch / lxVec3DBatchSoA the slots ARE the batches : a batch is written once by
+	the producer and read in place by the consumer, nothing is copied.
+	With T = pointer, ownership of an external batch is handed over.
+
+	Producer and consumer indices live on different cache lines (LX_CACHE_LINE)
+	so that the two sides do not invalidate each other on every operation.
+	Slots are allocated aligned on LX_CACHE_LINE.
+*/
+#ifndef LX_RING_H
+#define LX_RING_H
+
+#include <stdlib.h>
+#include <new>
+#include <atomic>
+#include "lxVectors.h"	// And includes lxHack.h, lxTypes.h
+
+#ifndef LX_CACHE_LINE
+#define LX_CACHE_LINE	(64)
+#endif
+
+namespace lx {
+
+	// =================================================================
+	//   Cache aligned batches of points.
+	// =================================================================
+
+	/** AoS batch, 'count' valid points */
+	template <u32 N>
+	class alignas(LX_CACHE_LINE) lxVec3DBatch {
+	public:
+		enum { CAPACITY = N };
+		u32		count;
+		Vec3D	points[N];
+	};
+
+	/** SoA batch, each component array starts on its own cache line */
+	template <u32 N>
+	class alignas(LX_CACHE_LINE) lxVec3DBatchSoA {
+	public:
+		enum { CAPACITY = N };
+		alignas(LX_CACHE_LINE) float x[N];
+		alignas(LX_CACHE_LINE) float y[N];
+		alignas(LX_CACHE_LINE) float z[N];
+		u32		count;
+	};
+
+	// =================================================================
+	//   Cache line aligned array of T (default constructed).
+	// =================================================================
+	template <class T>
+	class lxAlignedArray {
+	public:
+		lxAlignedArray(u32 count)
+		:m_count(count)
+		{
+			m_raw	= malloc(((size_t)count * sizeof(T)) + LX_CACHE_LINE);
+			m_data	= (T*)(((size_t)m_raw + LX_CACHE_LINE - 1) & ~(size_t)(LX_CACHE_LINE - 1));
+			for (u32 n = 0; n < count; n++) { new (&m_data[n]) T(); }
+		}
+
+		~lxAlignedArray() {
+			for (u32 n = 0; n < m_count; n++) { m_data[n].~T(); }
+			free(m_raw);
+		}
+
+		T&			operator[](u32 n)			{ return m_data[n]; }
+		const T&	operator[](u32 n) const		{ return m_data[n]; }
+
+	private:
+		lxAlignedArray(const lxAlignedArray&);
+		lxAlignedArray& operator=(const lxAlignedArray&);
+
+		T*		m_data;
+		void*	m_raw;
+		u32		m_count;
+	};
+
+	optinline
+	u32 lxRingCapacity(u32 capacity) {
+		if (capacity < 2)									{ return 2;	}
+		if (lxUnsignedInt32::ui_isPowerOf2(capacity))		{ return capacity; }
+		return lxUnsignedInt32::ui_closestPowerOf2(capacity);
+	}
+
+	// =================================================================
+	//   Single producer / single consumer.
+	// =================================================================
+	template <class T>
+	class lxSPSCRing {
+	public:
+		lxSPSCRing(u32 capacity)
+		:m_tail(0)
+		,m_cachedHead(0)
+		,m_head(0)
+		,m_cachedTail(0)
+		,m_capacity(lxRingCapacity(capacity))
+		,m_slots(m_capacity)
+		{ }
+
+		u32 Capacity() const { return m_capacity; }
+
+		/** Approximate when called while the other side is running */
+		u32 Size() const {
+			return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+		}
+
+		// --- Producer side ---
+
+		/** NULL if full. Slot stays owned by the producer until CommitWrite() */
+		T* TryAcquireWrite() {
+			u32 tail = m_tail.load(std::memory_order_relaxed);
+			if (tail - m_cachedHead == m_capacity) {
+				// Only read the consumer cache line when our snapshot says full.
+				m_cachedHead = m_head.load(std::memory_order_acquire);
+				if (tail - m_cachedHead == m_capacity) { return NULL; }
+			}
+			return &m_slots[lxUnsignedInt32::ui_moduloPower2(tail, m_capacity)];
+		}
+
+		void CommitWrite() {
+			m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		bool TryPush(const T& value) {
+			T* slot = TryAcquireWrite();
+			if (slot == NULL) { return false; }
+			*slot = value;
+			CommitWrite();
+			return true;
+		}
+
+		// --- Consumer side ---
+
+		/** NULL if empty. Slot stays owned by the consumer until ReleaseRead() */
+		T* TryAcquireRead() {
+			u32 head = m_head.load(std::memory_order_relaxed);
+			if (head == m_cachedTail) {
+				m_cachedTail = m_tail.load(std::memory_order_acquire);
+				if (head == m_cachedTail) { return NULL; }
+			}
+			return &m_slots[lxUnsignedInt32::ui_moduloPower2(head, m_capacity)];
+		}
+
+		void ReleaseRead() {
+			m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		bool TryPop(T& value) {
+			T* slot = TryAcquireRead();
+			if (slot == NULL) { return false; }
+			value = *slot;
+			ReleaseRead();
+			return true;
+		}
+
+	private:
+		lxSPSCRing(const lxSPSCRing&);
+		lxSPSCRing& operator=(const lxSPSCRing&);
+
+		// Producer cache line.
+		alignas(LX_CACHE_LINE) std::atomic<u32>	m_tail;
+		u32										m_cachedHead;
+		// Consumer cache line.
+		alignas(LX_CACHE_LINE) std::atomic<u32>	m_head;
+		u32										m_cachedTail;
+		// Read only after construction.
+		alignas(LX_CACHE_LINE) u32				m_capacity;
+		lxAlignedArray<T>						m_slots;
+	};
+
+	// =================================================================
+	//   Multi producer / multi consumer (bounded, Vyukov).
+	//   Each cell holds a sequence number telling which lap of the ring
+	//   it is ready for : seq == pos -> free for write at pos,
+	//   seq == pos + 1 -> written, ready for read at pos.
+	// =================================================================
+	template <class T>
+	class lxMPMCRing {
+	public:
+		lxMPMCRing(u32 capacity)
+		:m_enqueue(0)
+		,m_dequeue(0)
+		,m_capacity(lxRingCapacity(capacity))
+		,m_cells(m_capacity)
+		{
+			for (u32 n = 0; n < m_capacity; n++) {
+				m_cells[n].sequence.store(n, std::memory_order_relaxed);
+			}
+		}
+
+		u32 Capacity() const { return m_capacity; }
+
+		// --- Producer side ---
+
+		/** NULL if full. ticket must be given back to CommitWrite() */
+		T* TryAcquireWrite(u32& ticket) {
+			u32 pos = m_enqueue.load(std::memory_order_relaxed);
+			for (;;) {
+				Cell& cell = m_cells[lxUnsignedInt32::ui_moduloPower2(pos, m_capacity)];
+				s32 dif = (s32)(cell.sequence.load(std::memory_order_acquire) - pos);
+				if (dif == 0) {
+					if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						ticket = pos;
+						return &cell.data;
+					}
+					// pos reloaded by the failed CAS.
+				} else if (dif < 0) {
+					return NULL;	// Full : cell not yet released by the consumer of the previous lap.
+				} else {
+					pos = m_enqueue.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		void CommitWrite(u32 ticket) {
+			m_cells[lxUnsignedInt32::ui_moduloPower2(ticket, m_capacity)].sequence.store(ticket + 1, std::memory_order_release);
+		}
+
+		bool TryPush(const T& value) {
+			u32 ticket;
+			T* slot = TryAcquireWrite(ticket);
+			if (slot == NULL) { return false; }
+			*slot = value;
+			CommitWrite(ticket);
+			return true;
+		}
+
+		// --- Consumer side ---
+
+		/** NULL if empty. ticket must be given back to ReleaseRead() */
+		T* TryAcquireRead(u32& ticket) {
+			u32 pos = m_dequeue.load(std::memory_order_relaxed);
+			for (;;) {
+				Cell& cell = m_cells[lxUnsignedInt32::ui_moduloPower2(pos, m_capacity)];
+				s32 dif = (s32)(cell.sequence.load(std::memory_order_acquire) - (pos + 1));
+				if (dif == 0) {
+					if (m_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						ticket = pos;
+						return &cell.data;
+					}
+				} else if (dif < 0) {
+					return NULL;	// Empty.
+				} else {
+					pos = m_dequeue.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		void ReleaseRead(u32 ticket) {
+			// Ready for the write of the next lap.
+			m_cells[lxUnsignedInt32::ui_moduloPower2(ticket, m_capacity)].sequence.store(ticket + m_capacity, std::memory_order_release);
+		}
+
+		bool TryPop(T& value) {
+			u32 ticket;
+			T* slot = TryAcquireRead(ticket);
+			if (slot == NULL) { return false; }
+			value = *slot;
+			ReleaseRead(ticket);
+			return true;
+		}
+
+	private:
+		lxMPMCRing(const lxMPMCRing&);
+		lxMPMCRing& operator=(const lxMPMCRing&);
+
+		/** One cell per cache line : neighbor slots used by different threads do not false share */
+		class alignas(LX_CACHE_LINE) Cell {
+		public:
+			std::atomic<u32>	sequence;
+			T					data;
+		};
+
+		alignas(LX_CACHE_LINE) std::atomic<u32>	m_enqueue;
+		alignas(LX_CACHE_LINE) std::atomic<u32>	m_dequeue;
+		alignas(LX_CACHE_LINE) u32				m_capacity;
+		lxAlignedArray<Cell>					m_cells;
+	};
+
+} // End namespace
+
+#endif // LX_RING_H
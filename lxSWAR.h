@@ -0,0 +1,347 @@
+/**
+	SWAR : SIMD Within A Register.
+
+	Treat a u32 / u64 as 4 / 8 lanes of u8, or 2 / 4 lanes of u16,
+	using only integer ALU operations. For targets where no SIMD unit
+	can be assumed (or for code that must stay portable).
+
+	Same idea as lxBit::countOnes : mask the lane top bit (H) so that a carry
+	never crosses a lane boundary, then fix the top bit separately.
+
+	Lane primitives are templates on the word type : T = u32 or u64.
+	Masks returned by compare functions have all the bits of a lane set (0xFF / 0xFFFF)
+	when the condition is true, 0 otherwise.
+
+	Buffer routines work on u64 words and assume a little endian CPU (x86, ARM LE)
+	to convert a lane mask back to a byte index.
+*/
+#ifndef LX_SWAR_H
+#define LX_SWAR_H
+
+#include <string.h>		// memcpy for unaligned word load / store.
+#include "lxHack.h"		// And includes lxTypes.h
+
+namespace lx {
+
+	class lxSWAR {
+	public:
+		// =================================================================
+		//   Lane constants
+		// =================================================================
+
+		/** value replicated in each 8 bit lane (0x01 -> 0x01010101...) */
+		template <class T> optinline static
+		T lanes8(u32 value)		{	return (T)(((T)~(T)0 / 0xFF) * (T)(value & 0xFF));		}
+
+		/** value replicated in each 16 bit lane */
+		template <class T> optinline static
+		T lanes16(u32 value)	{	return (T)(((T)~(T)0 / 0xFFFF) * (T)(value & 0xFFFF));	}
+
+		// =================================================================
+		//   8 bit lanes
+		// =================================================================
+
+		/** Wrap around add */
+		template <class T> optinline static
+		T add8(T a, T b) {
+			const T H = lanes8<T>(0x80);
+			return ((a & ~H) + (b & ~H)) ^ ((a ^ b) & H);
+		}
+
+		/** Wrap around substract */
+		template <class T> optinline static
+		T sub8(T a, T b) {
+			const T H = lanes8<T>(0x80);
+			return ((a | H) - (b & ~H)) ^ ((a ^ ~b) & H);
+		}
+
+		/** Unsigned saturating add (clamp to 0xFF) */
+		template <class T> optinline static
+		T addSat8(T a, T b) {
+			const T H = lanes8<T>(0x80);
+			T sum   = add8(a, b);
+			T carry = ((a & b) | ((a | b) & ~sum)) & H;
+			// Lane with carry : 0x80 -> 0xFF
+			return sum | ((carry >> 7) * 0xFF);
+		}
+
+		/** Unsigned saturating substract (clamp to 0) */
+		template <class T> optinline static
+		T subSat8(T a, T b) {
+			const T H = lanes8<T>(0x80);
+			T dif    = sub8(a, b);
+			T borrow = ((~a & b) | ((~a | b) & dif)) & H;
+			return dif & ~((borrow >> 7) * 0xFF);
+		}
+
+		/** (a + b + 1) >> 1 per lane, same rounding as SSE pavgb */
+		template <class T> optinline static
+		T avgRound8(T a, T b)
+		{	return (a | b) - (((a ^ b) >> 1) & lanes8<T>(0x7F));		}
+
+		/** (a + b) >> 1 per lane */
+		template <class T> optinline static
+		T avgFloor8(T a, T b)
+		{	return (a & b) + (((a ^ b) >> 1) & lanes8<T>(0x7F));		}
+
+		/** Top bit of each lane set when the lane is 0. Exact (no false positive in any lane). */
+		template <class T> optinline static
+		T zeroLanesH8(T x) {
+			const T L7 = lanes8<T>(0x7F);
+			return ~(((x & L7) + L7) | x | L7);
+		}
+
+		/** Non zero if any lane is 0. Cheaper, but the mask itself is only valid up to the first zero lane. */
+		template <class T> optinline static
+		T hasZero8(T x)
+		{	return (x - lanes8<T>(0x01)) & ~x & lanes8<T>(0x80);		}
+
+		/** Non zero if any lane is equal to value */
+		template <class T> optinline static
+		T hasValue8(T x, u32 value)
+		{	return hasZero8<T>(x ^ lanes8<T>(value));					}
+
+		template <class T> optinline static
+		T cmpEq8(T a, T b)
+		{	return (zeroLanesH8<T>(a ^ b) >> 7) * 0xFF;				}
+
+		/** Unsigned a < b */
+		template <class T> optinline static
+		T cmpLt8(T a, T b) {
+			T borrow = ((~a & b) | ((~a | b) & sub8(a, b))) & lanes8<T>(0x80);
+			return (borrow >> 7) * 0xFF;
+		}
+
+		/** Unsigned a > b */
+		template <class T> optinline static
+		T cmpGt8(T a, T b)
+		{	return cmpLt8(b, a);	}
+
+		/** Number of 1 bits inside each lane */
+		template <class T> optinline static
+		T countOnes8(T x) {
+			x -= ((x >> 1) & lanes8<T>(0x55));
+			x  = ((x >> 2) & lanes8<T>(0x33)) + (x & lanes8<T>(0x33));
+			return ((x >> 4) + x) & lanes8<T>(0x0F);
+		}
+
+		/** Sum of all lanes (up to 8 lanes * 255 fits in 16 bit) */
+		template <class T> optinline static
+		u32 horizontalSum8(T x) {
+			T pairs = (x & lanes16<T>(0x00FF)) + ((x >> 8) & lanes16<T>(0x00FF));
+			// Multiply by 0x0001000100010001 accumulate all 16 bit lanes into the top one.
+			return (u32)((pairs * lanes16<T>(0x0001)) >> (sizeof(T) * 8 - 16));
+		}
+
+		// =================================================================
+		//   16 bit lanes
+		// =================================================================
+
+		template <class T> optinline static
+		T add16(T a, T b) {
+			const T H = lanes16<T>(0x8000);
+			return ((a & ~H) + (b & ~H)) ^ ((a ^ b) & H);
+		}
+
+		template <class T> optinline static
+		T sub16(T a, T b) {
+			const T H = lanes16<T>(0x8000);
+			return ((a | H) - (b & ~H)) ^ ((a ^ ~b) & H);
+		}
+
+		template <class T> optinline static
+		T addSat16(T a, T b) {
+			const T H = lanes16<T>(0x8000);
+			T sum   = add16(a, b);
+			T carry = ((a & b) | ((a | b) & ~sum)) & H;
+			return sum | ((carry >> 15) * 0xFFFF);
+		}
+
+		template <class T> optinline static
+		T subSat16(T a, T b) {
+			const T H = lanes16<T>(0x8000);
+			T dif    = sub16(a, b);
+			T borrow = ((~a & b) | ((~a | b) & dif)) & H;
+			return dif & ~((borrow >> 15) * 0xFFFF);
+		}
+
+		template <class T> optinline static
+		T avgRound16(T a, T b)
+		{	return (a | b) - (((a ^ b) >> 1) & lanes16<T>(0x7FFF));	}
+
+		template <class T> optinline static
+		T avgFloor16(T a, T b)
+		{	return (a & b) + (((a ^ b) >> 1) & lanes16<T>(0x7FFF));	}
+
+		template <class T> optinline static
+		T zeroLanesH16(T x) {
+			const T L15 = lanes16<T>(0x7FFF);
+			return ~(((x & L15) + L15) | x | L15);
+		}
+
+		template <class T> optinline static
+		T hasZero16(T x)
+		{	return (x - lanes16<T>(0x0001)) & ~x & lanes16<T>(0x8000);	}
+
+		template <class T> optinline static
+		T cmpEq16(T a, T b)
+		{	return (zeroLanesH16<T>(a ^ b) >> 15) * 0xFFFF;			}
+
+		template <class T> optinline static
+		T cmpLt16(T a, T b) {
+			T borrow = ((~a & b) | ((~a | b) & sub16(a, b))) & lanes16<T>(0x8000);
+			return (borrow >> 15) * 0xFFFF;
+		}
+
+		template <class T> optinline static
+		T cmpGt16(T a, T b)
+		{	return cmpLt16(b, a);	}
+
+		template <class T> optinline static
+		T countOnes16(T x) {
+			x = countOnes8(x);
+			return (x + (x >> 8)) & lanes16<T>(0x001F);
+		}
+
+		// =================================================================
+		//   Buffer routines (u64 words, little endian)
+		// =================================================================
+
+		optinline static
+		u64 load64(const u8* p)				{	u64 w; memcpy(&w, p, 8); return w;	}
+
+		optinline static
+		void store64(u8* p, u64 w)			{	memcpy(p, &w, 8);					}
+
+		/** Index of the lowest lane having its top bit set in mask (mask != 0) */
+		optinline static
+		u32 firstLaneIndex8(u64 maskH) {
+			u64 below = (maskH & (0 - maskH)) - 1;
+			return (lxBit::countOnes((u32)below) + lxBit::countOnes((u32)(below >> 32))) >> 3;
+		}
+
+		/** memchr like : index of the first byte equal to value, size if not found */
+		static
+		u32 findByte(const u8* buffer, u32 size, u8 value) {
+			const u64 pattern = lanes8<u64>(value);
+			u32 n = 0;
+			for (; n + 8 <= size; n += 8) {
+				u64 w = load64(&buffer[n]) ^ pattern;
+				// hasZero8 is enough to detect, its lowest set lane is exact.
+				u64 m = hasZero8<u64>(w);
+				if (m) {
+					return n + firstLaneIndex8(m);
+				}
+			}
+			for (; n < size; n++) {
+				if (buffer[n] == value) { return n; }
+			}
+			return size;
+		}
+
+		/** Number of bytes equal to value */
+		static
+		u32 countByte(const u8* buffer, u32 size, u8 value) {
+			const u64 pattern = lanes8<u64>(value);
+			u32 total = 0;
+			u32 n = 0;
+			while (n + 8 <= size) {
+				// Per lane counters (1 per match) : flush before a lane can overflow.
+				u64 acc = 0;
+				for (u32 it = 0; (it < 255) && (n + 8 <= size); it++, n += 8) {
+					acc += zeroLanesH8<u64>(load64(&buffer[n]) ^ pattern) >> 7;
+				}
+				total += horizontalSum8<u64>(acc);
+			}
+			for (; n < size; n++) {
+				total += (buffer[n] == value);
+			}
+			return total;
+		}
+
+		/** Byte histogram. histogram[256] is cleared first.
+			4 sub tables so that consecutive equal bytes do not serialize on the same counter. */
+		static
+		void histogram(const u8* buffer, u32 size, u32* histogram) {
+			u32 sub[4][256];
+			memset(sub, 0, sizeof(sub));
+			u32 n = 0;
+			for (; n + 8 <= size; n += 8) {
+				u64 w = load64(&buffer[n]);
+				sub[0][(w      ) & 0xFF]++;
+				sub[1][(w >>  8) & 0xFF]++;
+				sub[2][(w >> 16) & 0xFF]++;
+				sub[3][(w >> 24) & 0xFF]++;
+				sub[0][(w >> 32) & 0xFF]++;
+				sub[1][(w >> 40) & 0xFF]++;
+				sub[2][(w >> 48) & 0xFF]++;
+				sub[3][(w >> 56)       ]++;
+			}
+			for (; n < size; n++) {
+				sub[0][buffer[n]]++;
+			}
+			for (u32 v = 0; v < 256; v++) {
+				histogram[v] = sub[0][v] + sub[1][v] + sub[2][v] + sub[3][v];
+			}
+		}
+
+		/** out = (a + b + 1) >> 1 per byte. out may alias a or b. */
+		static
+		void blendAverage(const u8* a, const u8* b, u8* out, u32 size) {
+			u32 n = 0;
+			for (; n + 8 <= size; n += 8) {
+				store64(&out[n], avgRound8<u64>(load64(&a[n]), load64(&b[n])));
+			}
+			for (; n < size; n++) {
+				out[n] = (u8)((a[n] + b[n] + 1) >> 1);
+			}
+		}
+
+		/** out = min(a + b, 255) per byte. out may alias a or b. */
+		static
+		void addSaturate(const u8* a, const u8* b, u8* out, u32 size) {
+			u32 n = 0;
+			for (; n + 8 <= size; n += 8) {
+				store64(&out[n], addSat8<u64>(load64(&a[n]), load64(&b[n])));
+			}
+			for (; n < size; n++) {
+				u32 s = a[n] + b[n];
+				out[n] = (u8)(s > 255 ? 255 : s);
+			}
+		}
+
+		/** out = max(a - b, 0) per byte. out may alias a or b. */
+		static
+		void subSaturate(const u8* a, const u8* b, u8* out, u32 size) {
+			u32 n = 0;
+			for (; n + 8 <= size; n += 8) {
+				store64(&out[n], subSat8<u64>(load64(&a[n]), load64(&b[n])));
+			}
+			for (; n < size; n++) {
+				out[n] = (u8)(a[n] > b[n] ? a[n] - b[n] : 0);
+			}
+		}
+
+		/** out = (a * (256 - alpha) + b * alpha) >> 8 per byte, alpha in [0..256].
+			Even and odd bytes are processed as 16 bit lanes : 255 * 256 fits in a lane. */
+		static
+		void blendAlpha(const u8* a, const u8* b, u8* out, u32 size, u32 alpha) {
+			const u64 M  = lanes16<u64>(0x00FF);
+			const u64 ia = 256 - alpha;
+			u32 n = 0;
+			for (; n + 8 <= size; n += 8) {
+				u64 wa = load64(&a[n]);
+				u64 wb = load64(&b[n]);
+				u64 even = (((wa & M) * ia + (wb & M) * alpha) >> 8) & M;
+				u64 odd  = ((((wa >> 8) & M) * ia + ((wb >> 8) & M) * alpha)) & ~M;
+				store64(&out[n], even | odd);
+			}
+			for (; n < size; n++) {
+				out[n] = (u8)((a[n] * ia + b[n] * alpha) >> 8);
+			}
+		}
+	};
+
+} // End namespace
+
+#endif // LX_SWAR_H
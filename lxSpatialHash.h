@@ -0,0 +1,460 @@
+/**
+	Flat spatial hash grid for Vec2D / Vec3D neighbor queries.
+
+	- Space is cut into cubic cells of cellSize.
+	- A cell is hashed into one of bucketCount buckets, bucketCount is a power of 2
+	  (lxUnsignedInt32::ui_closestPowerOf2 of the point count) so the modulo is a AND
+	  (lxUnsignedInt32::ui_moduloPower2).
+	- Points are stored sorted by bucket (counting sort) as CSR arrays :
+	  bucket b points are [bucketStart[b] .. bucketStart[b+1]).
+	  A copy of the points is kept in the same order for cache locality.
+
+	No allocation per point or per bucket : buffers are reused from one Build to the next
+	and only grow when the point count grows.
+
+	Cell coordinates are computed once per point (hashing pass) and reused by the scatter pass.
+
+	BuildParallel : each thread hashes a contiguous chunk of the points into its own bucket counts,
+	a thread-major prefix sum gives each (thread, bucket) its write position, then each thread scatters
+	its chunk without atomics. Result is identical to Build (same order inside each bucket).
+	Cost : threadCount * bucketCount u32 of counts, cleared and summed in parallel.
+
+	Queries return the original point index and the squared distance (Vec::SqrDistancePointPoint).
+	Each sorted point also keeps its cell coordinates : hash collisions are filtered
+	without computing a distance, and a bucket reached from two cells is never reported twice.
+*/
+#ifndef LX_SPATIALHASH_H
+#define LX_SPATIALHASH_H
+
+#include <math.h>
+#include <vector>
+#include "lxVectors.h"	// And includes lxHack.h, lxTypes.h
+#include "lxParallel.h"
+
+namespace lx {
+
+	// =================================================================
+	//   Per vector type helpers. Cell coordinates are always 3 s32,
+	//   z cell is 0 in 2D.
+	// =================================================================
+	template <class VEC> class lxSpatialHashTraits;
+
+	/** floorf + cast without the libm call (floorf is a call on x86 without SSE4.1).
+		Valid while |f| fits in a s32, like the cast it replaces. */
+	optinline
+	s32 lxFloorToInt(float f) {
+		s32 i = (s32)f;				// Truncate toward 0.
+		return i - (f < (float)i);	// Negative non integer : one less.
+	}
+
+	template <> class lxSpatialHashTraits<Vec2D> {
+	public:
+		enum { DIM = 2 };
+
+		optinline static
+		void CellOf(const Vec2D& p, float invCellSize, s32* cell) {
+			cell[0] = lxFloorToInt(p.x * invCellSize);
+			cell[1] = lxFloorToInt(p.y * invCellSize);
+			cell[2] = 0;
+		}
+
+		optinline static
+		float Coord(const Vec2D& p, u32 axis)
+		{	return (axis == 0) ? p.x : p.y;		}
+	};
+
+	template <> class lxSpatialHashTraits<Vec3D> {
+	public:
+		enum { DIM = 3 };
+
+		optinline static
+		void CellOf(const Vec3D& p, float invCellSize, s32* cell) {
+			cell[0] = lxFloorToInt(p.x * invCellSize);
+			cell[1] = lxFloorToInt(p.y * invCellSize);
+			cell[2] = lxFloorToInt(p.z * invCellSize);
+		}
+
+		optinline static
+		float Coord(const Vec3D& p, u32 axis)
+		{	return (axis == 0) ? p.x : ((axis == 1) ? p.y : p.z);	}
+	};
+
+	template <class VEC>
+	class lxSpatialHashGrid {
+	public:
+		typedef lxSpatialHashTraits<VEC> Traits;
+
+		lxSpatialHashGrid(float cellSize)
+		:m_cellSize(cellSize)
+		,m_invCellSize(1.0f / cellSize)
+		,m_bucketCount(0)
+		,m_pointCount(0)
+		{ }
+
+		/** Cell size change is taken into account at next Build */
+		void SetCellSize(float cellSize) {
+			m_cellSize    = cellSize;
+			m_invCellSize = 1.0f / cellSize;
+		}
+
+		float	GetCellSize()		const	{ return m_cellSize;	}
+		u32		GetBucketCount()	const	{ return m_bucketCount;	}
+		u32		GetPointCount()		const	{ return m_pointCount;	}
+
+		optinline static
+		u32 HashCell(const s32* cell) {
+			// Teschner et al. primes, then fold the high bits down : low bits are used by the mask.
+			u32 h = ((u32)cell[0] * 73856093U) ^ ((u32)cell[1] * 19349663U) ^ ((u32)cell[2] * 83492791U);
+			return h ^ (h >> 16);
+		}
+
+		optinline
+		u32 BucketOfCell(const s32* cell) const
+		{	return lxUnsignedInt32::ui_moduloPower2(HashCell(cell), m_bucketCount);	}
+
+		// =================================================================
+		//   Build
+		// =================================================================
+
+		void Build(const VEC* points, u32 count) {
+			Prepare(count);
+			u32* bucketStart = &m_bucketStart[0];
+			for (u32 b = 0; b <= m_bucketCount; b++) { bucketStart[b] = 0; }
+
+			s32 cell[3];
+			for (u32 n = 0; n < count; n++) {
+				Traits::CellOf(points[n], m_invCellSize, cell);
+				u32 b = BucketOfCell(cell);
+				m_pointBucket[n] = b;
+				StoreInputCell(n, cell);
+				bucketStart[b + 1]++;
+			}
+			for (u32 b = 0; b < m_bucketCount; b++) { bucketStart[b + 1] += bucketStart[b]; }
+
+			// Scatter : bucketStart[b] is used as cursor then restored by a shift.
+			for (u32 n = 0; n < count; n++) {
+				u32 w = bucketStart[m_pointBucket[n]]++;
+				Scatter(points, n, w);
+			}
+			for (u32 b = m_bucketCount; b > 0; b--) { bucketStart[b] = bucketStart[b - 1]; }
+			bucketStart[0] = 0;
+		}
+
+		/** threadCount = 0 : lxParallel::DefaultThreadCount() */
+		void BuildParallel(const VEC* points, u32 count, u32 threadCount = 0) {
+			if (threadCount == 0)		{ threadCount = lxParallel::DefaultThreadCount();	}
+			if (threadCount > count)	{ threadCount = count;								}
+			if (threadCount <= 1)		{ Build(points, count); return;						}
+
+			Prepare(count);
+			const u32 bucketCount = m_bucketCount;
+			// Row t : bucket counts of thread t, then its write cursors.
+			m_threadBucket.resize((size_t)threadCount * bucketCount);
+			m_threadTotal .resize(threadCount + 1);
+			u32*				threadBucket	= &m_threadBucket[0];
+			u32*				threadTotal		= &m_threadTotal[0];
+			u32*				bucketStart		= &m_bucketStart[0];
+			u32*				pointBucket		= &m_pointBucket[0];
+			lxSpatialHashGrid*	self			= this;
+
+			// 1 - Hash and count, thread t owns row t : no sharing.
+			lxParallel::For(count, threadCount, [=](u32 begin, u32 end, u32 t) {
+				u32* counts = &threadBucket[(size_t)t * bucketCount];
+				for (u32 b = 0; b < bucketCount; b++) { counts[b] = 0; }
+				s32 cell[3];
+				for (u32 n = begin; n < end; n++) {
+					Traits::CellOf(points[n], self->m_invCellSize, cell);
+					u32 b = self->BucketOfCell(cell);
+					pointBucket[n] = b;
+					self->StoreInputCell(n, cell);
+					counts[b]++;
+				}
+			});
+
+			// 2 - Prefix sum, bucket major then thread major : (b, t) starts after every (b' < b)
+			//     and after (b, t' < t). Done on bucket ranges in parallel, the range bases in serial.
+			lxParallel::For(bucketCount, threadCount, [=](u32 begin, u32 end, u32 r) {
+				u32 total = 0;
+				for (u32 b = begin; b < end; b++) {
+					for (u32 t = 0; t < threadCount; t++) { total += threadBucket[(size_t)t * bucketCount + b]; }
+				}
+				threadTotal[r + 1] = total;
+			});
+			threadTotal[0] = 0;
+			for (u32 r = 0; r < threadCount; r++) { threadTotal[r + 1] += threadTotal[r]; }
+			lxParallel::For(bucketCount, threadCount, [=](u32 begin, u32 end, u32 r) {
+				u32 pos = threadTotal[r];
+				for (u32 b = begin; b < end; b++) {
+					bucketStart[b] = pos;
+					for (u32 t = 0; t < threadCount; t++) {
+						u32& c = threadBucket[(size_t)t * bucketCount + b];
+						u32 n  = c;
+						c      = pos;
+						pos   += n;
+					}
+				}
+			});
+			bucketStart[bucketCount] = count;
+
+			// 3 - Scatter, same chunks as pass 1 : each thread writes to its own cursors.
+			lxParallel::For(count, threadCount, [=](u32 begin, u32 end, u32 t) {
+				u32* cursor = &threadBucket[(size_t)t * bucketCount];
+				for (u32 n = begin; n < end; n++) {
+					self->Scatter(points, n, cursor[pointBucket[n]]++);
+				}
+			});
+		}
+
+		// =================================================================
+		//   Radius query
+		// =================================================================
+
+		/** All points with SqrDistance <= radius^2.
+			Write up to maxResults results, return the total number of points found
+			(can be bigger than maxResults, order is not sorted). */
+		u32 QueryRadius(const VEC& center, float radius, u32* outIndices, float* outSqrDist, u32 maxResults) const {
+			if (m_pointCount == 0) { return 0; }
+
+			const float radiusSqr = radius * radius;
+			s32 lo[3] = { 0, 0, 0 };
+			s32 hi[3] = { 0, 0, 0 };
+			// Checked in float first : a huge (or infinite) radius must not reach the s32 cast.
+			bool linear = !(radius * m_invCellSize < (float)m_bucketCount);
+			if (!linear) {
+				// Stop as soon as the running product reaches bucketCount : each axis can span up to
+				// 2 * bucketCount cells, the full 3D product would overflow a u64 and wrap below bucketCount.
+				u64 cellCount = 1;
+				for (u32 a = 0; a < (u32)Traits::DIM; a++) {
+					float c = Traits::Coord(center, a);
+					lo[a] = lxFloorToInt((c - radius) * m_invCellSize);
+					hi[a] = lxFloorToInt((c + radius) * m_invCellSize);
+					cellCount *= (u64)(hi[a] - lo[a] + 1);
+					if (cellCount >= m_bucketCount) { linear = true; break; }
+				}
+			}
+
+			u32 found = 0;
+			if (linear) {
+				// Radius bigger than the grid density : linear scan is cheaper.
+				for (u32 i = 0; i < m_pointCount; i++) {
+					float d = VEC::SqrDistancePointPoint(center, m_sorted[i]);
+					if (d <= radiusSqr) {
+						if (found < maxResults) { outIndices[found] = m_indices[i]; outSqrDist[found] = d; }
+						found++;
+					}
+				}
+				return found;
+			}
+
+			s32 cell[3];
+			for (cell[2] = lo[2]; cell[2] <= hi[2]; cell[2]++) {
+			for (cell[1] = lo[1]; cell[1] <= hi[1]; cell[1]++) {
+			for (cell[0] = lo[0]; cell[0] <= hi[0]; cell[0]++) {
+				u32 b = BucketOfCell(cell);
+				for (u32 i = m_bucketStart[b]; i < m_bucketStart[b + 1]; i++) {
+					if (!SameCell(i, cell)) { continue; }
+					float d = VEC::SqrDistancePointPoint(center, m_sorted[i]);
+					if (d <= radiusSqr) {
+						if (found < maxResults) { outIndices[found] = m_indices[i]; outSqrDist[found] = d; }
+						found++;
+					}
+				}
+			}}}
+			return found;
+		}
+
+		/** Query n results start at [n * maxPerQuery], outCounts[n] is clamped to maxPerQuery.
+			threadCount = 0 : lxParallel::DefaultThreadCount() */
+		void QueryRadiusBatch(const VEC* centers, u32 queryCount, float radius, u32 maxPerQuery,
+							  u32* outIndices, float* outSqrDist, u32* outCounts, u32 threadCount = 1) const {
+			const lxSpatialHashGrid* self = this;
+			lxParallel::For(queryCount, threadCount, [=](u32 begin, u32 end, u32) {
+				for (u32 n = begin; n < end; n++) {
+					u64 base = (u64)n * maxPerQuery;
+					u32 c = self->QueryRadius(centers[n], radius, &outIndices[base], &outSqrDist[base], maxPerQuery);
+					outCounts[n] = (c < maxPerQuery) ? c : maxPerQuery;
+				}
+			});
+		}
+
+		// =================================================================
+		//   K nearest query
+		// =================================================================
+
+		/** Up to k nearest points within maxRadius, sorted by increasing squared distance.
+			Cells are visited by rings (shell of a cube) around the center cell, stop as soon as no
+			unvisited ring can hold a closer point. When the ring cube holds more cells than there are
+			buckets, finish with a linear scan : cost is bounded by O(bucketCount + pointCount).
+			maxRadius can be infinite (unbounded search). Return the number of results (<= k). */
+		u32 QueryKNearest(const VEC& center, u32 k, float maxRadius, u32* outIndices, float* outSqrDist) const {
+			if ((m_pointCount == 0) || (k == 0)) { return 0; }
+
+			const float maxRadiusSqr = maxRadius * maxRadius;
+			s32 centerCell[3];
+			Traits::CellOf(center, m_invCellSize, centerCell);
+
+			// Ring count covering maxRadius, clamped in float before the cast.
+			float rings   = maxRadius * m_invCellSize;
+			s32   maxRing = (rings < (float)RING_LIMIT) ? ((s32)rings + 2) : RING_LIMIT;
+
+			u32 found = 0;
+			for (s32 ring = 0; ring <= maxRing; ring++) {
+				u64 side = (u64)(2 * ring + 1);
+				u64 cubeCells = (Traits::DIM == 3) ? (side * side * side) : (side * side);
+				if (cubeCells >= m_bucketCount) {
+					return KNearestLinear(center, k, maxRadiusSqr, outIndices, outSqrDist);
+				}
+
+				s32 lo[3] = { centerCell[0] - ring, centerCell[1] - ring, centerCell[2] - ring };
+				s32 hi[3] = { centerCell[0] + ring, centerCell[1] + ring, centerCell[2] + ring };
+				s32 cell[3];
+				if (ring == 0) {
+					VisitCellKNearest(centerCell, center, k, maxRadiusSqr, found, outIndices, outSqrDist);
+				} else if (Traits::DIM == 2) {
+					cell[2] = 0;
+					VisitSquareRing(lo, hi, cell, center, k, maxRadiusSqr, found, outIndices, outSqrDist);
+				} else {
+					// Bottom and top faces, full squares.
+					for (s32 face = 0; face < 2; face++) {
+						cell[2] = face ? hi[2] : lo[2];
+						for (cell[1] = lo[1]; cell[1] <= hi[1]; cell[1]++) {
+						for (cell[0] = lo[0]; cell[0] <= hi[0]; cell[0]++) {
+							VisitCellKNearest(cell, center, k, maxRadiusSqr, found, outIndices, outSqrDist);
+						}}
+					}
+					// Side faces : square ring on each slice between them.
+					for (cell[2] = lo[2] + 1; cell[2] < hi[2]; cell[2]++) {
+						VisitSquareRing(lo, hi, cell, center, k, maxRadiusSqr, found, outIndices, outSqrDist);
+					}
+				}
+
+				// Any point in ring+1 or further is at least ring * cellSize away.
+				if (found == k) {
+					float reach = (float)ring * m_cellSize;
+					if (outSqrDist[k - 1] <= reach * reach) { break; }
+				}
+			}
+			return found;
+		}
+
+		/** Query n results start at [n * k]. threadCount = 0 : lxParallel::DefaultThreadCount() */
+		void QueryKNearestBatch(const VEC* centers, u32 queryCount, u32 k, float maxRadius,
+								u32* outIndices, float* outSqrDist, u32* outCounts, u32 threadCount = 1) const {
+			const lxSpatialHashGrid* self = this;
+			lxParallel::For(queryCount, threadCount, [=](u32 begin, u32 end, u32) {
+				for (u32 n = begin; n < end; n++) {
+					u64 base = (u64)n * k;
+					outCounts[n] = self->QueryKNearest(centers[n], k, maxRadius, &outIndices[base], &outSqrDist[base]);
+				}
+			});
+		}
+
+	private:
+		lxSpatialHashGrid(const lxSpatialHashGrid&);
+		lxSpatialHashGrid& operator=(const lxSpatialHashGrid&);
+
+		void Prepare(u32 count) {
+			m_pointCount  = count;
+			m_bucketCount = lxUnsignedInt32::ui_closestPowerOf2(count);
+			// resize() does not release memory : no allocation once the biggest frame was seen.
+			m_bucketStart.resize(m_bucketCount + 1);
+			m_pointBucket.resize(count);
+			m_indices    .resize(count);
+			m_sorted     .resize(count);
+			m_cells      .resize((size_t)count * Traits::DIM);
+			m_inputCells .resize((size_t)count * Traits::DIM);
+		}
+
+		optinline
+		void StoreInputCell(u32 n, const s32* cell) {
+			for (u32 a = 0; a < (u32)Traits::DIM; a++) { m_inputCells[(size_t)n * Traits::DIM + a] = cell[a]; }
+		}
+
+		/** Input point n goes to sorted position w, cell comes from the hashing pass */
+		optinline
+		void Scatter(const VEC* points, u32 n, u32 w) {
+			m_indices[w] = n;
+			m_sorted [w] = points[n];
+			for (u32 a = 0; a < (u32)Traits::DIM; a++) {
+				m_cells[(size_t)w * Traits::DIM + a] = m_inputCells[(size_t)n * Traits::DIM + a];
+			}
+		}
+
+		optinline
+		bool SameCell(u32 i, const s32* cell) const {
+			const s32* c = &m_cells[(size_t)i * Traits::DIM];
+			for (u32 a = 0; a < (u32)Traits::DIM; a++) {
+				if (c[a] != cell[a]) { return false; }
+			}
+			return true;
+		}
+
+		/** Rings further than this are never enumerated (radius clamp, the linear scan takes over before) */
+		enum { RING_LIMIT = 1 << 16 };
+
+		/** Insert (index, d) into the sorted k results */
+		optinline static
+		void InsertKNearest(u32 index, float d, u32 k, u32& found, u32* outIndices, float* outSqrDist) {
+			if ((found == k) && (d >= outSqrDist[k - 1])) { return; }
+			u32 pos = (found < k) ? found++ : (k - 1);
+			while ((pos > 0) && (outSqrDist[pos - 1] > d)) {
+				outSqrDist[pos] = outSqrDist[pos - 1];
+				outIndices[pos] = outIndices[pos - 1];
+				pos--;
+			}
+			outSqrDist[pos] = d;
+			outIndices[pos] = index;
+		}
+
+		void VisitCellKNearest(const s32* cell, const VEC& center, u32 k, float maxRadiusSqr,
+							   u32& found, u32* outIndices, float* outSqrDist) const {
+			u32 b = BucketOfCell(cell);
+			for (u32 i = m_bucketStart[b]; i < m_bucketStart[b + 1]; i++) {
+				if (!SameCell(i, cell)) { continue; }
+				float d = VEC::SqrDistancePointPoint(center, m_sorted[i]);
+				if (d <= maxRadiusSqr) { InsertKNearest(m_indices[i], d, k, found, outIndices, outSqrDist); }
+			}
+		}
+
+		/** Border of the [lo..hi] square in x,y at z = cell[2] */
+		void VisitSquareRing(const s32* lo, const s32* hi, s32* cell, const VEC& center, u32 k, float maxRadiusSqr,
+							 u32& found, u32* outIndices, float* outSqrDist) const {
+			for (cell[0] = lo[0]; cell[0] <= hi[0]; cell[0]++) {
+				cell[1] = lo[1];	VisitCellKNearest(cell, center, k, maxRadiusSqr, found, outIndices, outSqrDist);
+				cell[1] = hi[1];	VisitCellKNearest(cell, center, k, maxRadiusSqr, found, outIndices, outSqrDist);
+			}
+			for (cell[1] = lo[1] + 1; cell[1] < hi[1]; cell[1]++) {
+				cell[0] = lo[0];	VisitCellKNearest(cell, center, k, maxRadiusSqr, found, outIndices, outSqrDist);
+				cell[0] = hi[0];	VisitCellKNearest(cell, center, k, maxRadiusSqr, found, outIndices, outSqrDist);
+			}
+		}
+
+		u32 KNearestLinear(const VEC& center, u32 k, float maxRadiusSqr, u32* outIndices, float* outSqrDist) const {
+			u32 found = 0;
+			for (u32 i = 0; i < m_pointCount; i++) {
+				float d = VEC::SqrDistancePointPoint(center, m_sorted[i]);
+				if (d <= maxRadiusSqr) { InsertKNearest(m_indices[i], d, k, found, outIndices, outSqrDist); }
+			}
+			return found;
+		}
+
+		float				m_cellSize;
+		float				m_invCellSize;
+		u32					m_bucketCount;	// Power of 2
+		u32					m_pointCount;
+		std::vector<u32>	m_bucketStart;	// CSR, m_bucketCount + 1 entries
+		std::vector<u32>	m_pointBucket;	// Input order, build temporary
+		std::vector<u32>	m_indices;		// Sorted order -> original index
+		std::vector<VEC>	m_sorted;		// Sorted copy of the points
+		std::vector<s32>	m_cells;		// Sorted order, DIM cell coordinates per point
+		std::vector<s32>	m_inputCells;	// Input order, build temporary
+		std::vector<u32>	m_threadBucket;	// BuildParallel, threadCount rows of bucketCount counts / cursors
+		std::vector<u32>	m_threadTotal;	// BuildParallel, point count per bucket range, then range base
+	};
+
+	typedef lxSpatialHashGrid<Vec2D>	lxSpatialHashGrid2D;
+	typedef lxSpatialHashGrid<Vec3D>	lxSpatialHashGrid3D;
+
+} // End namespace
+
+#endif // LX_SPATIALHASH_H
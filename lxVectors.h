@@ -11,6 +11,10 @@ public:
 	float x;
 	float y;
 	
+	/** Leave members uninitialized, allow bulk buffer allocation (new Vec2D[n]) */
+	Vec2D()
+	{ }
+
 	Vec2D(float value) 
 	:x(value)
 	,y(value)
@@ -26,6 +30,12 @@ public:
 	,y(vec.y)
 	{ }
 
+	inline Vec2D& operator=(const Vec2D& vec) {
+		x = vec.x;
+		y = vec.y;
+		return (*this);
+	}
+
 	inline Vec2D operator-(void) const {
 		return Vec2D(-x, -y);
 	}
@@ -119,6 +129,11 @@ public:
 	inline Vec2D Cross(const Vec2D& v) {
 		return Vec2D(x * v.y, y * v.x);
 	}
+
+	/** Scalar 2D cross product (perp-dot) : z of the 3D cross product, > 0 if v is counter clockwise from this */
+	inline float PerpDot(const Vec2D& v) const {
+		return (x * v.y) - (y * v.x);
+	}
     
 	inline float Length() {
 		return sqrt(LengthSqr());
@@ -159,6 +174,12 @@ public:
 		return startSegment + (segment * factor);
 	}
 
+	inline static
+	/** > 0 if a,b,c counter clockwise, < 0 if clockwise, 0 if collinear (float precision, see lxGeometry2D for exact sign) */
+	float Orientation			(const Vec2D& a, const Vec2D& b, const Vec2D& c) {
+		return (b - a).PerpDot(c - a);
+	}
+
 };
 
 class Vec3D {
@@ -167,6 +188,10 @@ public:
 	float y;
 	float z;
 	
+	/** Leave members uninitialized, allow bulk buffer allocation (new Vec3D[n]) */
+	Vec3D()
+	{ }
+
 	Vec3D(float value) 
 	:x(value)
 	,y(value)
@@ -185,6 +210,13 @@ public:
 	,z(vec.z)
 	{ }
 
+	inline Vec3D& operator=(const Vec3D& vec) {
+		x = vec.x;
+		y = vec.y;
+		z = vec.z;
+		return (*this);
+	}
+
 	inline static
 	float SqrDistancePointPoint	(const Vec3D& pointA, const Vec3D& pointB) {
 		Vec3D dif = pointA - pointB;
@@ -320,13 +352,13 @@ public:
 	}
 
 	inline Vec3D NormalizeApprox() {
-		float lengthSqr = (x * x) + (y * y);
+		float lengthSqr = (x * x) + (y * y) + (z * z);
 		float invLength = lx::lxFloat::ApproxReciproqualSQRT(lengthSqr);
 		return Vec3D( x * invLength, y * invLength, z * invLength );
 	}
 
 	inline Vec3D Normalize() {
-		float lengthSqr = (x * x) + (y * y);
+		float lengthSqr = (x * x) + (y * y) + (z * z);
 		float invLength = 1.0f / sqrt(lengthSqr);
 		return Vec3D( x * invLength, y * invLength , z * invLength );
 	}
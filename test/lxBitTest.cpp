@@ -0,0 +1,204 @@
+/**
+	lxBit deposit / extract / interleave against a bit by bit reference.
+
+	Build & run (from the repository root), once without and once with BMI2 :
+		g++ -std=c++11 -O2 -I. test/lxBitTest.cpp -o lxBitTest && ./lxBitTest
+		g++ -std=c++11 -O2 -mbmi2 -I. test/lxBitTest.cpp -o lxBitTest && ./lxBitTest
+
+	Return 0 when every check passes, 1 otherwise (first failures are printed).
+*/
+#include <stdio.h>
+#include "../lxHack.h"
+#include "../lxRandom.h"
+
+using namespace lx;
+
+static u32 g_failCount = 0;
+
+static void Check(bool ok, const char* what, u64 x, u64 mask) {
+	if (ok) { return; }
+	if (g_failCount < 20) {
+		printf("FAIL %s x=%016llx mask=%016llx\n", what, (unsigned long long)x, (unsigned long long)mask);
+	}
+	g_failCount++;
+}
+
+// =================================================================
+//   Reference : one bit at a time.
+// =================================================================
+
+static u64 RefDeposit(u64 x, u64 mask) {
+	u64 res = 0;
+	u32 k   = 0;
+	for (u32 i = 0; i < 64; i++) {
+		if ((mask >> i) & 1) {
+			if ((x >> k) & 1) { res |= 1ULL << i; }
+			k++;
+		}
+	}
+	return res;
+}
+
+static u64 RefExtract(u64 x, u64 mask) {
+	u64 res = 0;
+	u32 k   = 0;
+	for (u32 i = 0; i < 64; i++) {
+		if ((mask >> i) & 1) {
+			if ((x >> i) & 1) { res |= 1ULL << k; }
+			k++;
+		}
+	}
+	return res;
+}
+
+// =================================================================
+//   Scalar paths
+// =================================================================
+
+static void TestScalar(u64 x, u64 mask) {
+	u32 x32    = (u32)x;
+	u32 mask32 = (u32)mask;
+	u32 dep32  = (u32)RefDeposit(x32, mask32);
+	u32 ext32  = (u32)RefExtract(x32, mask32);
+	u64 dep64  = RefDeposit(x, mask);
+	u64 ext64  = RefExtract(x, mask);
+
+	Check(lxBit::deposit32(x32, mask32) == dep32, "deposit32", x32, mask32);
+	Check(lxBit::extract32(x32, mask32) == ext32, "extract32", x32, mask32);
+	Check(lxBit::deposit64(x, mask)     == dep64, "deposit64", x, mask);
+	Check(lxBit::extract64(x, mask)     == ext64, "extract64", x, mask);
+
+	Check(lxBit::depositFast32(x32, mask32) == dep32, "depositFast32", x32, mask32);
+	Check(lxBit::extractFast32(x32, mask32) == ext32, "extractFast32", x32, mask32);
+	Check(lxBit::depositFast64(x, mask)     == dep64, "depositFast64", x, mask);
+	Check(lxBit::extractFast64(x, mask)     == ext64, "extractFast64", x, mask);
+
+#if defined(LX_HAS_BMI2)
+	Check(lxBit::deposit32_BMI2(x32, mask32) == dep32, "deposit32_BMI2", x32, mask32);
+	Check(lxBit::extract32_BMI2(x32, mask32) == ext32, "extract32_BMI2", x32, mask32);
+	Check(lxBit::deposit64_BMI2(x, mask)     == dep64, "deposit64_BMI2", x, mask);
+	Check(lxBit::extract64_BMI2(x, mask)     == ext64, "extract64_BMI2", x, mask);
+#endif
+
+	lxBitMask32 bm32(mask32);
+	lxBitMask64 bm64(mask);
+	Check(bm32.deposit(x32) == dep32, "lxBitMask32::deposit", x32, mask32);
+	Check(bm32.extract(x32) == ext32, "lxBitMask32::extract", x32, mask32);
+	Check(bm64.deposit(x)   == dep64, "lxBitMask64::deposit", x, mask);
+	Check(bm64.extract(x)   == ext64, "lxBitMask64::extract", x, mask);
+}
+
+// =================================================================
+//   Array paths (out of place and in place)
+// =================================================================
+
+#define ARRAY_COUNT	(37)	// Not a multiple of any vector width.
+
+static void TestArrays(lxPCG32& rnd, u64 mask) {
+	u32 mask32 = (u32)mask;
+	u32 in32 [ARRAY_COUNT], out32[ARRAY_COUNT], ref32[ARRAY_COUNT];
+	u64 in64 [ARRAY_COUNT], out64[ARRAY_COUNT], ref64[ARRAY_COUNT];
+	for (u32 n = 0; n < ARRAY_COUNT; n++) {
+		in64[n] = ((u64)rnd.Next() << 32) | rnd.Next();
+		in32[n] = (u32)in64[n];
+	}
+
+	lxBitMask32 bm32(mask32);
+	lxBitMask64 bm64(mask);
+
+	// --- 32 bit deposit ---
+	for (u32 n = 0; n < ARRAY_COUNT; n++) { ref32[n] = (u32)RefDeposit(in32[n], mask32); }
+	lxBit::deposit32Array		(in32, out32, ARRAY_COUNT, mask32);	for (u32 n = 0; n < ARRAY_COUNT; n++) { Check(out32[n] == ref32[n], "deposit32Array",		in32[n], mask32); }
+	lxBit::depositFast32Array	(in32, out32, ARRAY_COUNT, mask32);	for (u32 n = 0; n < ARRAY_COUNT; n++) { Check(out32[n] == ref32[n], "depositFast32Array",	in32[n], mask32); }
+	bm32.depositArray			(in32, out32, ARRAY_COUNT);			for (u32 n = 0; n < ARRAY_COUNT; n++) { Check(out32[n] == ref32[n], "lxBitMask32::depositArray", in32[n], mask32); }
+
+	// --- 32 bit extract ---
+	for (u32 n = 0; n < ARRAY_COUNT; n++) { ref32[n] = (u32)RefExtract(in32[n], mask32); }
+	lxBit::extract32Array		(in32, out32, ARRAY_COUNT, mask32);	for (u32 n = 0; n < ARRAY_COUNT; n++) { Check(out32[n] == ref32[n], "extract32Array",		in32[n], mask32); }
+	lxBit::extractFast32Array	(in32, out32, ARRAY_COUNT, mask32);	for (u32 n = 0; n < ARRAY_COUNT; n++) { Check(out32[n] == ref32[n], "extractFast32Array",	in32[n], mask32); }
+	bm32.extractArray			(in32, out32, ARRAY_COUNT);			for (u32 n = 0; n < ARRAY_COUNT; n++) { Check(out32[n] == ref32[n], "lxBitMask32::extractArray", in32[n], mask32); }
+
+	// --- 64 bit deposit ---
+	for (u32 n = 0; n < ARRAY_COUNT; n++) { ref64[n] = RefDeposit(in64[n], mask); }
+	lxBit::deposit64Array		(in64, out64, ARRAY_COUNT, mask);	for (u32 n = 0; n < ARRAY_COUNT; n++) { Check(out64[n] == ref64[n], "deposit64Array",		in64[n], mask); }
+	lxBit::depositFast64Array	(in64, out64, ARRAY_COUNT, mask);	for (u32 n = 0; n < ARRAY_COUNT; n++) { Check(out64[n] == ref64[n], "depositFast64Array",	in64[n], mask); }
+	bm64.depositArray			(in64, out64, ARRAY_COUNT);			for (u32 n = 0; n < ARRAY_COUNT; n++) { Check(out64[n] == ref64[n], "lxBitMask64::depositArray", in64[n], mask); }
+
+	// --- 64 bit extract ---
+	for (u32 n = 0; n < ARRAY_COUNT; n++) { ref64[n] = RefExtract(in64[n], mask); }
+	lxBit::extract64Array		(in64, out64, ARRAY_COUNT, mask);	for (u32 n = 0; n < ARRAY_COUNT; n++) { Check(out64[n] == ref64[n], "extract64Array",		in64[n], mask); }
+	lxBit::extractFast64Array	(in64, out64, ARRAY_COUNT, mask);	for (u32 n = 0; n < ARRAY_COUNT; n++) { Check(out64[n] == ref64[n], "extractFast64Array",	in64[n], mask); }
+	bm64.extractArray			(in64, out64, ARRAY_COUNT);			for (u32 n = 0; n < ARRAY_COUNT; n++) { Check(out64[n] == ref64[n], "lxBitMask64::extractArray", in64[n], mask); }
+
+	// --- In place (in == out) ---
+	for (u32 n = 0; n < ARRAY_COUNT; n++) { out32[n] = in32[n]; ref32[n] = (u32)RefDeposit(in32[n], mask32); }
+	lxBit::deposit32Array(out32, out32, ARRAY_COUNT, mask32);
+	for (u32 n = 0; n < ARRAY_COUNT; n++) { Check(out32[n] == ref32[n], "deposit32Array in place", in32[n], mask32); }
+
+	for (u32 n = 0; n < ARRAY_COUNT; n++) { out64[n] = in64[n]; ref64[n] = RefExtract(in64[n], mask); }
+	bm64.extractArray(out64, out64, ARRAY_COUNT);
+	for (u32 n = 0; n < ARRAY_COUNT; n++) { Check(out64[n] == ref64[n], "lxBitMask64::extractArray in place", in64[n], mask); }
+}
+
+// =================================================================
+//   Interleave (Morton 2D)
+// =================================================================
+
+static void TestInterleave(u32 x, u32 y) {
+	x &= 0xFFFF;
+	y &= 0xFFFF;
+	u32 code = lxBit::interleave2(x, y);
+	u32 rx, ry;
+	lxBit::deinterleave2(code, rx, ry);
+	Check((rx == x) && (ry == y), "deinterleave2(interleave2)", x, y);
+	// Same as depositing x on the even bits and y on the odd bits.
+	Check(code == (u32)(RefDeposit(x, 0x55555555) | RefDeposit(y, 0xAAAAAAAA)), "interleave2", x, y);
+}
+
+int main() {
+	lxPCG32 rnd(0x1234567);
+
+	// Edge masks : empty, full, single bits, top bit, alternating.
+	static const u64 EDGE_MASKS[] = {
+		0ULL, ~0ULL, 1ULL, 0x80000000ULL, 0x8000000000000000ULL,
+		0x5555555555555555ULL, 0xAAAAAAAAAAAAAAAAULL, 0x00000000FFFFFFFFULL, 0xFFFFFFFF00000000ULL,
+		0x8000000000000001ULL, 0x0F0F0F0F0F0F0F0FULL,
+	};
+	const u32 edgeCount = (u32)(sizeof(EDGE_MASKS) / sizeof(EDGE_MASKS[0]));
+	for (u32 m = 0; m < edgeCount; m++) {
+		TestScalar(0ULL,  EDGE_MASKS[m]);
+		TestScalar(~0ULL, EDGE_MASKS[m]);
+		for (u32 n = 0; n < 256; n++) {
+			TestScalar(((u64)rnd.Next() << 32) | rnd.Next(), EDGE_MASKS[m]);
+		}
+		TestArrays(rnd, EDGE_MASKS[m]);
+	}
+	for (u32 b = 0; b < 64; b++) {
+		TestScalar(~0ULL, 1ULL << b);
+		TestScalar(1ULL << b, ~0ULL);
+	}
+
+	// Random masks, dense and sparse.
+	for (u32 n = 0; n < 100000; n++) {
+		u64 x    = ((u64)rnd.Next() << 32) | rnd.Next();
+		u64 mask = ((u64)rnd.Next() << 32) | rnd.Next();
+		if (n & 1) { mask &= ((u64)rnd.Next() << 32) | rnd.Next(); }
+		TestScalar(x, mask);
+		if ((n & 255) == 0) { TestArrays(rnd, mask); }
+	}
+
+	TestInterleave(0, 0);
+	TestInterleave(0xFFFF, 0xFFFF);
+	TestInterleave(0xFFFF, 0);
+	for (u32 n = 0; n < 100000; n++) {
+		TestInterleave(rnd.Next(), rnd.Next());
+	}
+
+#if defined(LX_HAS_BMI2)
+	const char* path = "BMI2";
+#else
+	const char* path = "portable";
+#endif
+	printf("lxBitTest (%s) : %s, %u failure(s)\n", path, g_failCount ? "FAILED" : "OK", g_failCount);
+	return g_failCount ? 1 : 0;
+}
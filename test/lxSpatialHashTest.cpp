@@ -0,0 +1,173 @@
+/**
+	lxSpatialHashGrid radius and k nearest queries against a brute force reference,
+	plus edge cases (empty build, infinite radius, huge radius cell count).
+
+	Build & run (from the repository root) :
+		g++ -std=c++11 -O2 -pthread -I. test/lxSpatialHashTest.cpp -o lxSpatialHashTest && ./lxSpatialHashTest
+
+	Return 0 when every check passes, 1 otherwise (first failures are printed).
+*/
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include "../lxSpatialHash.h"
+#include "../lxRandom.h"
+
+using namespace lx;
+
+static u32 g_failCount = 0;
+
+static void Check(bool ok, const char* what, u32 a, u32 b) {
+	if (ok) { return; }
+	if (g_failCount < 20) {
+		printf("FAIL %s (%u / %u)\n", what, a, b);
+	}
+	g_failCount++;
+}
+
+// =================================================================
+//   Random points
+// =================================================================
+
+static void RandomPoints(lxXoshiro128Plus_x4& rnd, Vec2D* out, u32 count, float size) {
+	std::vector<float> f(count * 2);
+	rnd.FillUniform(&f[0], count * 2);
+	for (u32 n = 0; n < count; n++) { out[n] = Vec2D(f[n * 2] * size, f[n * 2 + 1] * size); }
+}
+
+static void RandomPoints(lxXoshiro128Plus_x4& rnd, Vec3D* out, u32 count, float size) {
+	std::vector<float> f(count * 3);
+	rnd.FillUniform(&f[0], count * 3);
+	for (u32 n = 0; n < count; n++) { out[n] = Vec3D(f[n * 3] * size, f[n * 3 + 1] * size, f[n * 3 + 2] * size); }
+}
+
+// =================================================================
+//   Queries against brute force
+// =================================================================
+
+template <class VEC>
+static void TestQueries(lxXoshiro128Plus_x4& rnd, u32 count, float cellSize, bool parallel) {
+	const u32	QUERIES	= 64;
+	const u32	K		= 8;
+	const float	SIZE	= 10.0f;
+
+	std::vector<VEC> points(count);
+	VEC centers[QUERIES];
+	RandomPoints(rnd, &points[0], count, SIZE);
+	RandomPoints(rnd, centers, QUERIES, SIZE);
+
+	lxSpatialHashGrid<VEC> grid(cellSize);
+	if (parallel)	{ grid.BuildParallel(&points[0], count, 4);	}
+	else			{ grid.Build(&points[0], count);			}
+
+	std::vector<u32>	indices(count);
+	std::vector<float>	sqrDist(count);
+	const float RADII[] = { 0.0f, cellSize * 0.5f, cellSize * 2.5f, SIZE * 0.3f, SIZE * 4.0f, INFINITY };
+
+	for (u32 q = 0; q < QUERIES; q++) {
+		for (u32 r = 0; r < sizeof(RADII) / sizeof(RADII[0]); r++) {
+			float radius = RADII[r];
+			std::vector<u32> ref;
+			for (u32 n = 0; n < count; n++) {
+				if (VEC::SqrDistancePointPoint(centers[q], points[n]) <= radius * radius) { ref.push_back(n); }
+			}
+			u32 found = grid.QueryRadius(centers[q], radius, &indices[0], &sqrDist[0], count);
+			std::sort(indices.begin(), indices.begin() + found);
+			Check(found == ref.size(), "QueryRadius count", found, (u32)ref.size());
+			Check((found == ref.size()) && std::equal(ref.begin(), ref.end(), indices.begin()), "QueryRadius indices", q, r);
+
+			std::vector<float> refDist;
+			for (u32 n = 0; n < count; n++) {
+				float d = VEC::SqrDistancePointPoint(centers[q], points[n]);
+				if (d <= radius * radius) { refDist.push_back(d); }
+			}
+			std::sort(refDist.begin(), refDist.end());
+			if (refDist.size() > K) { refDist.resize(K); }
+			u32 kFound = grid.QueryKNearest(centers[q], K, radius, &indices[0], &sqrDist[0]);
+			Check(kFound == refDist.size(), "QueryKNearest count", kFound, (u32)refDist.size());
+			Check((kFound == refDist.size()) && std::equal(refDist.begin(), refDist.end(), sqrDist.begin()), "QueryKNearest distances", q, r);
+		}
+	}
+}
+
+/** BuildParallel keeps the input order inside each bucket : queries return exactly what Build gives */
+template <class VEC>
+static void TestParallelMatchesBuild(lxXoshiro128Plus_x4& rnd, u32 count, float cellSize, u32 threadCount) {
+	std::vector<VEC> points(count);
+	VEC center;
+	RandomPoints(rnd, &points[0], count, 10.0f);
+	RandomPoints(rnd, &center, 1, 10.0f);
+
+	lxSpatialHashGrid<VEC> serial(cellSize);
+	lxSpatialHashGrid<VEC> parallel(cellSize);
+	serial  .Build(&points[0], count);
+	parallel.BuildParallel(&points[0], count, threadCount);
+
+	std::vector<u32> a(count), b(count);
+	std::vector<float> d(count);
+	u32 foundA = serial  .QueryRadius(center, 3.0f, &a[0], &d[0], count);
+	u32 foundB = parallel.QueryRadius(center, 3.0f, &b[0], &d[0], count);
+	Check((foundA == foundB) && std::equal(a.begin(), a.begin() + foundA, b.begin()), "BuildParallel order", foundA, foundB);
+}
+
+// =================================================================
+//   Edge cases
+// =================================================================
+
+static void TestEmpty() {
+	lxSpatialHashGrid3D grid(1.0f);
+	grid.BuildParallel(NULL, 0, 4);
+	u32 index; float d;
+	Check(grid.QueryRadius(Vec3D(0, 0, 0), INFINITY, &index, &d, 1) == 0, "empty QueryRadius", 0, 0);
+	Check(grid.QueryKNearest(Vec3D(0, 0, 0), 1, INFINITY, &index, &d) == 0, "empty QueryKNearest", 0, 0);
+}
+
+/** Few points, tiny cells : an infinite k nearest search must fall back to the linear scan, not walk rings */
+static void TestSparse() {
+	Vec3D points[4] = { Vec3D(100, 100, 100), Vec3D(-50, 3, 2), Vec3D(1.0e6f, 0, 0), Vec3D(0.5f, 0, 0) };
+	lxSpatialHashGrid3D grid(0.001f);
+	grid.Build(points, 4);
+	u32 indices[4]; float sqrDist[4];
+	u32 found = grid.QueryKNearest(Vec3D(0, 0, 0), 4, INFINITY, indices, sqrDist);
+	Check((found == 4) && (indices[0] == 3) && (indices[1] == 1) && (indices[2] == 0) && (indices[3] == 2), "sparse QueryKNearest", found, 4);
+	Check(grid.QueryRadius(Vec3D(0, 0, 0), 3.0e9f, indices, sqrDist, 4) == 4, "sparse QueryRadius 3e9", 0, 0);
+}
+
+/** Regression : 2^22 buckets, each axis spans 2^22 cells, the 3D product 2^66 wrapped to 0 in u64
+	and the query enumerated every cell instead of switching to the linear scan. */
+static void TestHugeCellCount() {
+	const u32 COUNT = 4194304;
+	lxXoshiro128Plus_x4 rnd(7);
+	std::vector<Vec3D> points(COUNT);
+	RandomPoints(rnd, &points[0], COUNT, 100.0f);
+
+	lxSpatialHashGrid3D grid(1.0f);
+	grid.Build(&points[0], COUNT);
+	std::vector<u32>	indices(COUNT);
+	std::vector<float>	sqrDist(COUNT);
+	u32 found = grid.QueryRadius(Vec3D(0.5f, 0.5f, 0.5f), 2097151.5f, &indices[0], &sqrDist[0], COUNT);
+	Check(found == COUNT, "QueryRadius huge cell count", found, COUNT);
+}
+
+int main() {
+	lxXoshiro128Plus_x4 rnd(1);
+
+	for (u32 parallel = 0; parallel < 2; parallel++) {
+		TestQueries<Vec2D>(rnd, 5000, 0.25f, parallel != 0);
+		TestQueries<Vec2D>(rnd, 3,    0.25f, parallel != 0);
+		TestQueries<Vec3D>(rnd, 5000, 0.5f,  parallel != 0);
+		TestQueries<Vec3D>(rnd, 3,    0.5f,  parallel != 0);
+	}
+	for (u32 threadCount = 2; threadCount <= 7; threadCount++) {
+		TestParallelMatchesBuild<Vec2D>(rnd, 20000, 0.1f, threadCount);
+		TestParallelMatchesBuild<Vec3D>(rnd, 20000, 0.3f, threadCount);
+		TestParallelMatchesBuild<Vec3D>(rnd, threadCount + 1, 0.3f, threadCount);
+	}
+	TestEmpty();
+	TestSparse();
+	TestHugeCellCount();
+
+	printf("lxSpatialHashTest : %s, %u failure(s)\n", g_failCount ? "FAILED" : "OK", g_failCount);
+	return g_failCount ? 1 : 0;
+}